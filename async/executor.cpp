@@ -0,0 +1,50 @@
+#include "executor.h"
+
+Executor::Executor() {
+    m_thread = std::thread([this] { Run(); });
+}
+
+Executor::~Executor() {
+    Stop();
+}
+
+void Executor::Post(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(handle);
+    }
+    m_cv.notify_one();
+}
+
+bool Executor::IsCurrentThread() const {
+    return std::this_thread::get_id() == m_thread.get_id();
+}
+
+void Executor::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_one();
+
+    if (m_thread.joinable() && !IsCurrentThread()) {
+        m_thread.join();
+    }
+}
+
+void Executor::Run() {
+    while (true) {
+        std::coroutine_handle<> handle;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+
+            if (m_queue.empty()) break; // Stopping and drained
+
+            handle = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        handle.resume();
+    }
+}
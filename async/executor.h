@@ -0,0 +1,45 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// Single-threaded executor that resumes coroutines in FIFO order.
+// `co_await executor.Schedule()` moves the rest of a coroutine onto its thread.
+class Executor {
+public:
+    Executor();
+    ~Executor();
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    struct ScheduleAwaiter {
+        Executor& executor;
+
+        bool await_ready() const noexcept { return executor.IsCurrentThread(); }
+        void await_suspend(std::coroutine_handle<> handle) { executor.Post(handle); }
+        void await_resume() const noexcept {}
+    };
+
+    ScheduleAwaiter Schedule() {
+        return { *this };
+    }
+
+    void Post(std::coroutine_handle<> handle);
+    bool IsCurrentThread() const;
+
+    // Stops accepting work, drains what is queued and joins the worker
+    void Stop();
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::coroutine_handle<>> m_queue;
+    bool m_stopping = false;
+    std::thread m_thread;
+
+    void Run();
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+
+// Counts detached coroutines (and callbacks) that use an owner's state, so the owner can cancel them and
+// wait them out before tearing that state down. A task holds a Scope for its whole lifetime and checks
+// IsCancelled() after each resume to stop early.
+class TaskTracker {
+public:
+    class Scope {
+    public:
+        Scope() = default;
+        explicit Scope(TaskTracker* tracker) : m_tracker(tracker) {}
+        Scope(Scope&& other) noexcept : m_tracker(std::exchange(other.m_tracker, nullptr)) {}
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        Scope& operator=(Scope&&) = delete;
+
+        ~Scope() {
+            if (m_tracker) m_tracker->Leave();
+        }
+
+        // False once cancellation has started; the task must return without touching anything
+        explicit operator bool() const {
+            return m_tracker != nullptr;
+        }
+
+    private:
+        TaskTracker* m_tracker = nullptr;
+    };
+
+    TaskTracker() = default;
+    TaskTracker(const TaskTracker&) = delete;
+    TaskTracker& operator=(const TaskTracker&) = delete;
+
+    Scope Enter() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_cancelled.load(std::memory_order_relaxed)) return {};
+        ++m_active;
+        return Scope(this);
+    }
+
+    bool IsCancelled() const {
+        return m_cancelled.load(std::memory_order_acquire);
+    }
+
+    // Refuses new tasks, then blocks until every entered one has left. Never call it from a tracked task,
+    // and keep whatever the tasks resume on (executors, HTTP) alive until it returns.
+    void CancelAndJoin() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cancelled.store(true, std::memory_order_release);
+        m_cv.wait(lock, [this] { return m_active == 0; });
+    }
+
+private:
+    void Leave() {
+        // Notify under the lock so the joiner cannot destroy the tracker mid-notify
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_active == 0) m_cv.notify_all();
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    size_t m_active = 0;
+    std::atomic<bool> m_cancelled{ false };
+};
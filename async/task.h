@@ -0,0 +1,200 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+// Lazily started coroutine task. Awaiting a Task starts it and resumes the
+// awaiter (by symmetric transfer) when it finishes; Detach() starts it as
+// fire-and-forget, and SyncWait() blocks a non-coroutine caller on it.
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+    struct TaskPromiseBase {
+        std::coroutine_handle<> continuation;
+        std::exception_ptr error;
+        bool detached = false;
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        template <typename Promise>
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+                auto& promise = handle.promise();
+                if (promise.detached) {
+                    handle.destroy();
+                    return std::noop_coroutine();
+                }
+                return promise.continuation ? promise.continuation : std::noop_coroutine();
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        void unhandled_exception() noexcept {
+            error = std::current_exception();
+        }
+    };
+
+    template <typename T>
+    struct TaskPromise : TaskPromiseBase {
+        std::optional<T> value;
+
+        Task<T> get_return_object() noexcept;
+        FinalAwaiter<TaskPromise> final_suspend() noexcept { return {}; }
+
+        template <typename U>
+        void return_value(U&& result) {
+            value.emplace(std::forward<U>(result));
+        }
+
+        T TakeResult() {
+            if (error) std::rethrow_exception(error);
+            return std::move(*value);
+        }
+    };
+
+    template <>
+    struct TaskPromise<void> : TaskPromiseBase {
+        Task<void> get_return_object() noexcept;
+        FinalAwaiter<TaskPromise> final_suspend() noexcept { return {}; }
+
+        void return_void() noexcept {}
+
+        void TakeResult() {
+            if (error) std::rethrow_exception(error);
+        }
+    };
+
+}
+
+template <typename T>
+class Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    Task() = default;
+    explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+    Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (m_handle) m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        if (m_handle) m_handle.destroy();
+    }
+
+    bool await_ready() const noexcept {
+        return !m_handle || m_handle.done();
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        m_handle.promise().continuation = awaiter;
+        return m_handle;
+    }
+
+    T await_resume() {
+        return m_handle.promise().TakeResult();
+    }
+
+    // Starts the task without an awaiter; the frame frees itself when done.
+    // Exceptions escaping a detached task are dropped.
+    void Detach() && {
+        auto handle = std::exchange(m_handle, nullptr);
+        if (!handle) return;
+        handle.promise().detached = true;
+        handle.resume();
+    }
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+namespace detail {
+
+    template <typename T>
+    Task<T> TaskPromise<T>::get_return_object() noexcept {
+        return Task<T>{ std::coroutine_handle<TaskPromise<T>>::from_promise(*this) };
+    }
+
+    inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+        return Task<void>{ std::coroutine_handle<TaskPromise<void>>::from_promise(*this) };
+    }
+
+    struct SyncWaitEvent {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool done = false;
+
+        void Set() {
+            // Notify under the lock so the waiter cannot destroy the event mid-notify
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+            cv.notify_one();
+        }
+
+        void Wait() {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return done; });
+        }
+    };
+
+    template <typename T>
+    Task<void> SyncWaitBody(Task<T> task, std::optional<T>& result, std::exception_ptr& error, SyncWaitEvent& done) {
+        try {
+            result.emplace(co_await std::move(task));
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        done.Set();
+    }
+
+    inline Task<void> SyncWaitBody(Task<void> task, std::exception_ptr& error, SyncWaitEvent& done) {
+        try {
+            co_await std::move(task);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        done.Set();
+    }
+
+}
+
+// Blocks the calling thread until task completes. Only for code that is not itself a coroutine.
+template <typename T>
+T SyncWait(Task<T> task) {
+    detail::SyncWaitEvent done;
+    std::exception_ptr error;
+
+    if constexpr (std::is_void_v<T>) {
+        detail::SyncWaitBody(std::move(task), error, done).Detach();
+        done.Wait();
+        if (error) std::rethrow_exception(error);
+    }
+    else {
+        std::optional<T> result;
+        detail::SyncWaitBody(std::move(task), result, error, done).Detach();
+        done.Wait();
+        if (error) std::rethrow_exception(error);
+        return std::move(*result);
+    }
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+struct UpdateQueueStats {
+    uint64_t pushed = 0;
+    uint64_t popped = 0;
+    uint64_t overwritten = 0;
+    size_t maxDepth = 0;
+    std::chrono::nanoseconds totalDwell{};
+    std::chrono::nanoseconds maxDwell{};
+};
+
+// Bounded lock-free ring carrying updates from the media callbacks to the publisher.
+// Each slot has a sequence number (Vyukov's bounded queue), so pushes and pops never
+// take a lock and several callback threads may push at once. When the ring is full
+// the oldest entry is discarded: only the newest state matters.
+template <typename T, size_t Capacity>
+class UpdateQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    UpdateQueue() {
+        for (size_t i = 0; i < Capacity; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    UpdateQueue(const UpdateQueue&) = delete;
+    UpdateQueue& operator=(const UpdateQueue&) = delete;
+
+    // Always enqueues; returns false if an older update had to be dropped to make room
+    bool Push(const T& value) {
+        bool kept = true;
+        while (!TryPush(value)) {
+            if (TryTake([](Slot&) {})) {
+                m_overwritten.fetch_add(1, std::memory_order_relaxed);
+                kept = false;
+            }
+        }
+
+        m_pushed.fetch_add(1, std::memory_order_relaxed);
+
+        size_t depth = Depth();
+        size_t maxDepth = m_maxDepth.load(std::memory_order_relaxed);
+        while (depth > maxDepth && !m_maxDepth.compare_exchange_weak(maxDepth, depth, std::memory_order_relaxed)) {
+        }
+        return kept;
+    }
+
+    // Consumer side; assigns into out so its buffers are reused
+    bool TryPop(T& out) {
+        return TryTake([&](Slot& slot) {
+            out = slot.value;
+
+            auto dwell = std::chrono::steady_clock::now() - slot.enqueuedAt;
+            m_totalDwell += dwell;
+            if (dwell > m_maxDwell) m_maxDwell = dwell;
+            ++m_popped;
+        });
+    }
+
+    size_t Depth() const {
+        size_t enqueued = m_enqueuePos.load(std::memory_order_relaxed);
+        size_t dequeued = m_dequeuePos.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    // Dwell figures are written by the consumer, so read them from the consumer thread
+    UpdateQueueStats Stats() const {
+        UpdateQueueStats stats;
+        stats.pushed = m_pushed.load(std::memory_order_relaxed);
+        stats.popped = m_popped;
+        stats.overwritten = m_overwritten.load(std::memory_order_relaxed);
+        stats.maxDepth = m_maxDepth.load(std::memory_order_relaxed);
+        stats.totalDwell = std::chrono::duration_cast<std::chrono::nanoseconds>(m_totalDwell);
+        stats.maxDwell = std::chrono::duration_cast<std::chrono::nanoseconds>(m_maxDwell);
+        return stats;
+    }
+
+private:
+    // Keeps producer and consumer cursors on separate cache lines
+    static constexpr size_t CacheLine = 64;
+
+    struct Slot {
+        std::atomic<size_t> sequence{ 0 };
+        std::chrono::steady_clock::time_point enqueuedAt{};
+        T value{};
+    };
+
+    std::array<Slot, Capacity> m_slots;
+
+    alignas(CacheLine) std::atomic<size_t> m_enqueuePos{ 0 };
+    alignas(CacheLine) std::atomic<size_t> m_dequeuePos{ 0 };
+
+    alignas(CacheLine) std::atomic<uint64_t> m_pushed{ 0 };
+    std::atomic<uint64_t> m_overwritten{ 0 };
+    std::atomic<size_t> m_maxDepth{ 0 };
+
+    uint64_t m_popped = 0;
+    std::chrono::steady_clock::duration m_totalDwell{};
+    std::chrono::steady_clock::duration m_maxDwell{};
+
+    bool TryPush(const T& value) {
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &m_slots[pos & (Capacity - 1)];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0) {
+                return false; // Full
+            }
+            else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->value = value;
+        slot->enqueuedAt = std::chrono::steady_clock::now();
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Claims the oldest slot, hands it to visit and releases it for reuse
+    template <typename Visit>
+    bool TryTake(Visit&& visit) {
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &m_slots[pos & (Capacity - 1)];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+            if (diff == 0) {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0) {
+                return false; // Empty
+            }
+            else {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        visit(*slot);
+        slot->sequence.store(pos + Capacity, std::memory_order_release);
+        return true;
+    }
+};
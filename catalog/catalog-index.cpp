@@ -0,0 +1,550 @@
+#include "catalog-index.h"
+
+#include <cstddef>
+#include <cstring>
+#include <cwctype>
+#include <fstream>
+#include <vector>
+
+#include "../strings/string-utils.h"
+
+#define CATALOG_MAGIC 0x58444943 // "CIDX"
+#define CATALOG_VERSION 1
+
+#define CATALOG_LOG_MAGIC 0x474F4C43 // "CLOG"
+#define CATALOG_LOG_VERSION 1
+
+#pragma pack(push, 1)
+struct CatalogHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t bucketCount;
+    uint32_t entryCount;
+};
+
+struct CatalogRecord {
+    uint64_t hash;
+    uint32_t keyOffset;
+    uint32_t keyLength;
+    uint32_t thumbnailOffset;
+    uint32_t thumbnailLength;
+    uint32_t albumUrlOffset;
+    uint32_t albumUrlLength;
+};
+
+struct CatalogLogHeader {
+    uint32_t magic;
+    uint32_t version;
+};
+
+// Checksum covers the three lengths and the bytes that follow, so a torn tail is detected on load
+struct CatalogLogRecord {
+    uint32_t keyLength;
+    uint32_t thumbnailLength;
+    uint32_t albumUrlLength;
+    uint32_t checksum;
+};
+#pragma pack(pop)
+
+static uint32_t LogChecksum(const CatalogLogRecord& record, const char* data, size_t size) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    auto mix = [&hash](const void* bytes, size_t length) {
+        for (size_t i = 0; i < length; ++i) {
+            hash ^= static_cast<const uint8_t*>(bytes)[i];
+            hash *= 16777619u;
+        }
+    };
+    mix(&record, offsetof(CatalogLogRecord, checksum));
+    mix(data, size);
+    return hash;
+}
+
+CatalogIndex::~CatalogIndex() {
+    Close();
+}
+
+bool CatalogIndex::Open(const std::wstring& path) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_path = path;
+    m_logPath = path + L".log";
+
+    bool mapped = Map();
+    OpenLog();
+
+    if (m_delta.size() >= CompactThreshold) {
+        CompactLocked();
+    }
+    return mapped || !m_delta.empty();
+}
+
+void CatalogIndex::Close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // The log is already durable; compaction waits for the next time it fills up
+    CloseLog();
+    m_delta.clear();
+    Unmap();
+}
+
+bool CatalogIndex::IsOpen() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_log != INVALID_HANDLE_VALUE;
+}
+
+bool CatalogIndex::OpenLog() {
+    CloseLog();
+    m_delta.clear();
+
+    m_log = CreateFileW(m_logPath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_log == INVALID_HANDLE_VALUE) {
+        OutputDebugStringA(("CatalogIndex: failed to open delta log: " + std::to_string(GetLastError()) + "\n").c_str());
+        return false;
+    }
+
+    LARGE_INTEGER size{};
+    GetFileSizeEx(m_log, &size);
+
+    std::string contents(static_cast<size_t>(size.QuadPart), '\0');
+    DWORD read = 0;
+    if (!contents.empty() && (!ReadFile(m_log, contents.data(), static_cast<DWORD>(contents.size()), &read, nullptr) || read != contents.size())) {
+        CloseLog();
+        return false;
+    }
+
+    // Replay every intact record; whatever follows the first bad one is a torn append and is cut off
+    size_t valid = 0;
+    CatalogLogHeader header{};
+    if (contents.size() >= sizeof(header)) {
+        memcpy(&header, contents.data(), sizeof(header));
+    }
+
+    if (header.magic == CATALOG_LOG_MAGIC && header.version == CATALOG_LOG_VERSION) {
+        valid = sizeof(header);
+        while (valid + sizeof(CatalogLogRecord) <= contents.size()) {
+            CatalogLogRecord record;
+            memcpy(&record, contents.data() + valid, sizeof(record));
+
+            size_t payload = size_t(record.keyLength) + record.thumbnailLength + record.albumUrlLength;
+            if (valid + sizeof(record) + payload > contents.size()) break;
+
+            const char* data = contents.data() + valid + sizeof(record);
+            if (LogChecksum(record, data, payload) != record.checksum) break;
+
+            CatalogEntry entry;
+            entry.thumbnailUrl.assign(data + record.keyLength, record.thumbnailLength);
+            entry.albumUrl.assign(data + record.keyLength + record.thumbnailLength, record.albumUrlLength);
+            m_delta[std::string(data, record.keyLength)] = std::move(entry);
+
+            valid += sizeof(record) + payload;
+        }
+    }
+
+    if (valid != contents.size() || valid == 0) {
+        LARGE_INTEGER position{};
+        position.QuadPart = static_cast<LONGLONG>(valid);
+        SetFilePointerEx(m_log, position, nullptr, FILE_BEGIN);
+        SetEndOfFile(m_log);
+
+        if (valid == 0) {
+            CatalogLogHeader fresh{ CATALOG_LOG_MAGIC, CATALOG_LOG_VERSION };
+            DWORD written = 0;
+            if (!WriteFile(m_log, &fresh, sizeof(fresh), &written, nullptr) || written != sizeof(fresh)) {
+                CloseLog();
+                return false;
+            }
+        }
+    }
+
+    LARGE_INTEGER end{};
+    SetFilePointerEx(m_log, end, nullptr, FILE_END);
+    return true;
+}
+
+void CatalogIndex::CloseLog() {
+    if (m_log != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_log);
+        m_log = INVALID_HANDLE_VALUE;
+    }
+}
+
+void CatalogIndex::EncodeLogRecord(const std::string& key, const CatalogEntry& entry, std::string& out) {
+    CatalogLogRecord record{};
+    record.keyLength = static_cast<uint32_t>(key.size());
+    record.thumbnailLength = static_cast<uint32_t>(entry.thumbnailUrl.size());
+    record.albumUrlLength = static_cast<uint32_t>(entry.albumUrl.size());
+
+    size_t recordStart = out.size();
+    out.append(sizeof(record), '\0');
+    size_t dataStart = out.size();
+    out += key;
+    out += entry.thumbnailUrl;
+    out += entry.albumUrl;
+
+    record.checksum = LogChecksum(record, out.data() + dataStart, out.size() - dataStart);
+    memcpy(out.data() + recordStart, &record, sizeof(record));
+}
+
+bool CatalogIndex::AppendLog(const std::string& records) {
+    if (m_log == INVALID_HANDLE_VALUE) return false;
+
+    // A lookup cache: a lost tail only costs a refetch, so there is no flush per append
+    DWORD written = 0;
+    if (!WriteFile(m_log, records.data(), static_cast<DWORD>(records.size()), &written, nullptr) || written != records.size()) {
+        OutputDebugStringA(("CatalogIndex: delta log append failed: " + std::to_string(GetLastError()) + "\n").c_str());
+
+        // Drop the partial write so later appends stay readable
+        LARGE_INTEGER back{};
+        back.QuadPart = -static_cast<LONGLONG>(written);
+        SetFilePointerEx(m_log, back, nullptr, FILE_CURRENT);
+        SetEndOfFile(m_log);
+        return false;
+    }
+    return true;
+}
+
+bool CatalogIndex::Map() {
+    Unmap();
+
+    m_file = CreateFileW(m_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) {
+        // No index built yet; lookups simply miss until the first flush
+        return false;
+    }
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(m_file, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(CatalogHeader))) {
+        Unmap();
+        return false;
+    }
+
+    m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_mapping) {
+        Unmap();
+        return false;
+    }
+
+    m_view = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    m_viewSize = static_cast<size_t>(size.QuadPart);
+    if (!m_view) {
+        Unmap();
+        return false;
+    }
+
+    const auto* header = reinterpret_cast<const CatalogHeader*>(m_view);
+    size_t tablesSize = sizeof(CatalogHeader) + size_t(header->bucketCount) * sizeof(uint32_t) + size_t(header->entryCount) * sizeof(CatalogRecord);
+    bool valid = header->magic == CATALOG_MAGIC &&
+        header->version == CATALOG_VERSION &&
+        header->bucketCount != 0 &&
+        (header->bucketCount & (header->bucketCount - 1)) == 0 &&
+        tablesSize <= m_viewSize;
+
+    if (!valid) {
+        OutputDebugStringA("CatalogIndex: index file is corrupt, ignoring it.\n");
+        Unmap();
+        return false;
+    }
+
+    return true;
+}
+
+void CatalogIndex::Unmap() {
+    if (m_view) {
+        UnmapViewOfFile(m_view);
+        m_view = nullptr;
+    }
+    m_viewSize = 0;
+
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+
+    if (m_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+}
+
+std::string CatalogIndex::NormalizeKey(const std::wstring& artist, const std::wstring& album) {
+    // Lowercase, trim and collapse whitespace so "The  Band " and "the band" share a key
+    auto normalize = [](const std::wstring& value, std::wstring& out) {
+        bool pendingSpace = false;
+        for (wchar_t c : value) {
+            if (std::iswspace(c)) {
+                pendingSpace = true;
+                continue;
+            }
+            if (pendingSpace && !out.empty() && out.back() != L'\x1f') {
+                out.push_back(L' ');
+            }
+            pendingSpace = false;
+            out.push_back(static_cast<wchar_t>(std::towlower(c)));
+        }
+    };
+
+    std::wstring key;
+    key.reserve(artist.size() + album.size() + 1);
+    normalize(artist, key);
+    key.push_back(L'\x1f');
+    normalize(album, key);
+
+    return WideToUTF8(key);
+}
+
+uint64_t CatalogIndex::Hash(const std::string& key) {
+    // FNV-1a
+    uint64_t hash = 1469598103934665603ull;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::optional<CatalogEntry> CatalogIndex::FindMapped(const std::string& key, uint64_t hash) const {
+    if (!m_view) return std::nullopt;
+
+    const auto* header = reinterpret_cast<const CatalogHeader*>(m_view);
+    const auto* buckets = reinterpret_cast<const uint32_t*>(m_view + sizeof(CatalogHeader));
+    const auto* records = reinterpret_cast<const CatalogRecord*>(buckets + header->bucketCount);
+    const auto* blob = reinterpret_cast<const char*>(records + header->entryCount);
+    size_t blobSize = m_viewSize - static_cast<size_t>(reinterpret_cast<const uint8_t*>(blob) - m_view);
+
+    auto inBlob = [&](uint32_t offset, uint32_t length) {
+        return size_t(offset) + length <= blobSize;
+    };
+
+    uint32_t mask = header->bucketCount - 1;
+    for (uint32_t probe = 0; probe < header->bucketCount; ++probe) {
+        uint32_t slot = buckets[(hash + probe) & mask];
+        if (slot == 0) break;
+        if (slot > header->entryCount) break;
+
+        const CatalogRecord& record = records[slot - 1];
+        if (record.hash != hash) continue;
+        if (!inBlob(record.keyOffset, record.keyLength) ||
+            !inBlob(record.thumbnailOffset, record.thumbnailLength) ||
+            !inBlob(record.albumUrlOffset, record.albumUrlLength)) break;
+
+        if (key.size() != record.keyLength || key.compare(0, key.size(), blob + record.keyOffset, record.keyLength) != 0) continue;
+
+        CatalogEntry entry;
+        entry.thumbnailUrl.assign(blob + record.thumbnailOffset, record.thumbnailLength);
+        entry.albumUrl.assign(blob + record.albumUrlOffset, record.albumUrlLength);
+        return entry;
+    }
+
+    return std::nullopt;
+}
+
+std::optional<CatalogEntry> CatalogIndex::Find(const std::wstring& artist, const std::wstring& album) {
+    std::string key = NormalizeKey(artist, album);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_delta.find(key);
+    if (it != m_delta.end()) {
+        return it->second;
+    }
+
+    return FindMapped(key, Hash(key));
+}
+
+void CatalogIndex::Add(const std::wstring& artist, const std::wstring& album, const CatalogEntry& entry) {
+    if (entry.thumbnailUrl.empty() && entry.albumUrl.empty()) return;
+
+    std::string key = NormalizeKey(artist, album);
+    std::string record;
+    EncodeLogRecord(key, entry, record);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    AppendLog(record);
+    m_delta[std::move(key)] = entry;
+
+    if (m_delta.size() >= CompactThreshold) {
+        CompactLocked();
+    }
+}
+
+bool CatalogIndex::Compact() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return CompactLocked();
+}
+
+bool CatalogIndex::CompactLocked() {
+    if (m_path.empty()) return false;
+    if (m_delta.empty()) return true;
+
+    // Merge the mapped table with the pending entries; pending ones win
+    std::unordered_map<std::string, CatalogEntry> merged;
+    if (m_view) {
+        const auto* header = reinterpret_cast<const CatalogHeader*>(m_view);
+        const auto* buckets = reinterpret_cast<const uint32_t*>(m_view + sizeof(CatalogHeader));
+        const auto* records = reinterpret_cast<const CatalogRecord*>(buckets + header->bucketCount);
+        const auto* blob = reinterpret_cast<const char*>(records + header->entryCount);
+        size_t blobSize = m_viewSize - static_cast<size_t>(reinterpret_cast<const uint8_t*>(blob) - m_view);
+
+        merged.reserve(header->entryCount + m_delta.size());
+        for (uint32_t i = 0; i < header->entryCount; ++i) {
+            const CatalogRecord& record = records[i];
+            if (size_t(record.keyOffset) + record.keyLength > blobSize ||
+                size_t(record.thumbnailOffset) + record.thumbnailLength > blobSize ||
+                size_t(record.albumUrlOffset) + record.albumUrlLength > blobSize) continue;
+
+            CatalogEntry entry;
+            entry.thumbnailUrl.assign(blob + record.thumbnailOffset, record.thumbnailLength);
+            entry.albumUrl.assign(blob + record.albumUrlOffset, record.albumUrlLength);
+            merged.emplace(std::string(blob + record.keyOffset, record.keyLength), std::move(entry));
+        }
+    }
+
+    for (auto& [key, entry] : m_delta) {
+        merged[key] = entry;
+    }
+
+    std::wstring tempPath = m_path + L".tmp";
+    if (!Write(tempPath, merged)) {
+        DeleteFileW(tempPath.c_str());
+        return false;
+    }
+
+    Unmap();
+    if (!MoveFileExW(tempPath.c_str(), m_path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        OutputDebugStringA(("CatalogIndex: failed to replace index: " + std::to_string(GetLastError()) + "\n").c_str());
+        DeleteFileW(tempPath.c_str());
+        Map();
+        return false;
+    }
+
+    // A crash before this point replays entries the new table already has, which is harmless
+    m_delta.clear();
+    if (m_log != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER position{};
+        position.QuadPart = sizeof(CatalogLogHeader);
+        SetFilePointerEx(m_log, position, nullptr, FILE_BEGIN);
+        SetEndOfFile(m_log);
+    }
+
+    return Map();
+}
+
+bool CatalogIndex::Write(const std::wstring& path, const std::unordered_map<std::string, CatalogEntry>& entries) {
+    uint32_t bucketCount = 16;
+    while (bucketCount < entries.size() * 2) bucketCount <<= 1;
+
+    std::vector<uint32_t> buckets(bucketCount, 0);
+    std::vector<CatalogRecord> records;
+    records.reserve(entries.size());
+    std::string blob;
+
+    auto append = [&blob](const std::string& value, uint32_t& offset, uint32_t& length) {
+        offset = static_cast<uint32_t>(blob.size());
+        length = static_cast<uint32_t>(value.size());
+        blob += value;
+    };
+
+    for (const auto& [key, entry] : entries) {
+        CatalogRecord record{};
+        record.hash = Hash(key);
+        append(key, record.keyOffset, record.keyLength);
+        append(entry.thumbnailUrl, record.thumbnailOffset, record.thumbnailLength);
+        append(entry.albumUrl, record.albumUrlOffset, record.albumUrlLength);
+        records.push_back(record);
+
+        uint32_t mask = bucketCount - 1;
+        for (uint32_t probe = 0; probe < bucketCount; ++probe) {
+            uint32_t& slot = buckets[(record.hash + probe) & mask];
+            if (slot == 0) {
+                slot = static_cast<uint32_t>(records.size());
+                break;
+            }
+        }
+    }
+
+    CatalogHeader header{ CATALOG_MAGIC, CATALOG_VERSION, bucketCount, static_cast<uint32_t>(records.size()) };
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(buckets.data()), buckets.size() * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(CatalogRecord));
+    out.write(blob.data(), blob.size());
+
+    return out.good();
+}
+
+bool CatalogIndex::ImportCsv(const std::wstring& csvPath) {
+    std::ifstream in(csvPath, std::ios::binary);
+    if (!in) {
+        OutputDebugStringA("CatalogIndex: failed to open CSV export.\n");
+        return false;
+    }
+
+    auto splitCsv = [](const std::string& line) {
+        std::vector<std::string> fields(1);
+        bool quoted = false;
+        for (size_t i = 0; i < line.size(); ++i) {
+            char c = line[i];
+            if (quoted) {
+                if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                    fields.back().push_back('"');
+                    ++i;
+                }
+                else if (c == '"') {
+                    quoted = false;
+                }
+                else {
+                    fields.back().push_back(c);
+                }
+            }
+            else if (c == '"') {
+                quoted = true;
+            }
+            else if (c == ',') {
+                fields.emplace_back();
+            }
+            else if (c != '\r') {
+                fields.back().push_back(c);
+            }
+        }
+        return fields;
+    };
+
+    size_t imported = 0;
+    std::string records;
+    std::string line;
+    bool firstLine = true;
+    while (std::getline(in, line)) {
+        if (firstLine) {
+            firstLine = false;
+            // Skip a UTF-8 BOM
+            if (line.rfind("\xEF\xBB\xBF", 0) == 0) line.erase(0, 3);
+        }
+
+        auto fields = splitCsv(line);
+        if (fields.size() < 3 || fields[0].empty() || fields[1].empty() || fields[2].empty()) continue;
+
+        CatalogEntry entry;
+        bool isCatalogId = fields[2].find_first_not_of("0123456789") == std::string::npos;
+        entry.albumUrl = isCatalogId ? "https://music.apple.com/album/" + fields[2] : fields[2];
+        if (fields.size() > 3) {
+            entry.thumbnailUrl = fields[3];
+        }
+
+        std::string key = NormalizeKey(UTF8ToWide(fields[0]), UTF8ToWide(fields[1]));
+        EncodeLogRecord(key, entry, records);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_delta[std::move(key)] = std::move(entry);
+        ++imported;
+    }
+
+    OutputDebugStringA(("CatalogIndex: imported " + std::to_string(imported) + " albums.\n").c_str());
+
+    // One log write for the whole export, then fold it in so lookups hit the table
+    std::lock_guard<std::mutex> lock(m_mutex);
+    AppendLog(records);
+    return CompactLocked();
+}
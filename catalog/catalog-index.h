@@ -0,0 +1,80 @@
+#pragma once
+
+#include <windows.h>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+struct CatalogEntry {
+    std::string thumbnailUrl;
+    std::string albumUrl;
+};
+
+// Offline artist/album -> URL index stored as a memory-mapped, open-addressed hash table
+// plus an append-only delta log of entries added since the table was last written.
+//
+// Table layout: CatalogHeader | uint32 buckets[bucketCount] | CatalogRecord records[entryCount] | string blob
+// A bucket holds (record index + 1), 0 meaning empty. String offsets are relative to the blob.
+//
+// Log layout (<path>.log): CatalogLogHeader | { CatalogLogRecord | key | thumbnail url | album url }...
+// Each Add appends one record; the log is folded into a new table once it reaches CompactThreshold.
+// Only the publisher-lease holder opens the index for writing, so the files have a single writer.
+class CatalogIndex {
+public:
+    CatalogIndex() = default;
+    ~CatalogIndex();
+
+    CatalogIndex(const CatalogIndex&) = delete;
+    CatalogIndex& operator=(const CatalogIndex&) = delete;
+
+    bool Open(const std::wstring& path);
+    void Close();
+    bool IsOpen();
+
+    std::optional<CatalogEntry> Find(const std::wstring& artist, const std::wstring& album);
+
+    // Appends to the delta log; the table itself is only rewritten on compaction
+    void Add(const std::wstring& artist, const std::wstring& album, const CatalogEntry& entry);
+
+    // Folds the delta log into a freshly written table and truncates the log
+    bool Compact();
+
+    // Merges a "artist,album,collection id or url[,artwork url]" CSV export into the index
+    bool ImportCsv(const std::wstring& csvPath);
+
+    static std::string NormalizeKey(const std::wstring& artist, const std::wstring& album);
+
+private:
+    static constexpr size_t CompactThreshold = 512;
+
+    std::wstring m_path;
+    std::wstring m_logPath;
+
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+    const uint8_t* m_view = nullptr;
+    size_t m_viewSize = 0;
+
+    HANDLE m_log = INVALID_HANDLE_VALUE;
+
+    std::mutex m_mutex;
+
+    // Entries in the delta log, newest value per key
+    std::unordered_map<std::string, CatalogEntry> m_delta;
+
+    bool Map();
+    void Unmap();
+    std::optional<CatalogEntry> FindMapped(const std::string& key, uint64_t hash) const;
+    bool CompactLocked();
+
+    bool OpenLog();
+    void CloseLog();
+    bool AppendLog(const std::string& records);
+
+    static void EncodeLogRecord(const std::string& key, const CatalogEntry& entry, std::string& out);
+
+    static uint64_t Hash(const std::string& key);
+    static bool Write(const std::wstring& path, const std::unordered_map<std::string, CatalogEntry>& entries);
+};
@@ -2,15 +2,24 @@
 #include <sstream>
 #include <iostream>
 #include <thread>
+#include <array>
+#include <future>
+#include <charconv>
+#include <cstring>
 
 // OP CODES
 #define HANDSHAKE 0
 #define FRAME 1
 
+#define PIPE_COUNT 10
+#define FRAME_HEADER_SIZE 8
+
 using json = nlohmann::json;
 
 DiscordIPC::DiscordIPC(const std::string& clientId)
     : clientId_(clientId), pipe_(INVALID_HANDLE_VALUE) {
+    frameBuffer_.reserve(8 * 1024);
+    responseBuffer_.reserve(16 * 1024);
 }
 
 DiscordIPC::~DiscordIPC() {
@@ -18,22 +27,43 @@ DiscordIPC::~DiscordIPC() {
 }
 
 bool DiscordIPC::Connect() {
-    for (int i = 0; i < 10; ++i) {
-        std::string pipeName = "\\\\.\\pipe\\discord-ipc-" + std::to_string(i);
-        pipe_ = CreateFileA(pipeName.c_str(), GENERIC_WRITE | GENERIC_READ, 0, nullptr, OPEN_EXISTING, 0, nullptr);
-        if (pipe_ != INVALID_HANDLE_VALUE) {
-            OutputDebugStringA(("Connected to " + pipeName + "\n").c_str());
-            if (!SendHandshake()) {
-                Close();
-                return false;
-            }
-
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-            return true;
+    // Probe every endpoint at once, then keep the lowest-numbered pipe that opened
+    std::array<std::future<HANDLE>, PIPE_COUNT> probes;
+    for (int i = 0; i < PIPE_COUNT; ++i) {
+        probes[i] = std::async(std::launch::async, [i] {
+            std::string pipeName = "\\\\.\\pipe\\discord-ipc-" + std::to_string(i);
+            return CreateFileA(pipeName.c_str(), GENERIC_WRITE | GENERIC_READ, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+            });
+    }
+
+    int connectedIndex = -1;
+    for (int i = 0; i < PIPE_COUNT; ++i) {
+        HANDLE handle = probes[i].get();
+        if (handle == INVALID_HANDLE_VALUE) continue;
+
+        if (connectedIndex == -1) {
+            pipe_ = handle;
+            connectedIndex = i;
+        }
+        else {
+            CloseHandle(handle);
         }
     }
-    OutputDebugStringA("Failed to connect to any Discord IPC pipe.\n");
-    return false;
+
+    if (connectedIndex == -1) {
+        OutputDebugStringA("Failed to connect to any Discord IPC pipe.\n");
+        return false;
+    }
+
+    OutputDebugStringA(("Connected to discord-ipc-" + std::to_string(connectedIndex) + "\n").c_str());
+
+    // Handshake returns once Discord has answered with READY
+    if (!SendHandshake()) {
+        Close();
+        return false;
+    }
+
+    return true;
 }
 
 void DiscordIPC::Close() {
@@ -50,28 +80,62 @@ bool DiscordIPC::SendHandshake() {
         {"v", 1},
         {"client_id", clientId_}
     };
-    return SendFrame(HANDSHAKE, payload);
+
+    json response;
+    if (!SendFrame(HANDSHAKE, payload, &response))
+        return false;
+
+    if (!response.is_object() || response.value("evt", "") != "READY") {
+        OutputDebugStringA("Discord IPC handshake was not acknowledged with READY.\n");
+        return false;
+    }
+
+    return true;
 }
 
-bool DiscordIPC::SendActivity(const json& activity) {
-    json payload = {
-        {"cmd", "SET_ACTIVITY"},
-        {"args", {
-            {"activity", activity},
-            {"pid", static_cast<int>(GetCurrentProcessId())}
-        }},
-        {"nonce", std::to_string(GetTickCount64())}
+bool DiscordIPC::SendActivity(std::string_view activity) {
+    auto appendNumber = [this](uint64_t value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        frameBuffer_.append(digits, result.ptr - digits);
     };
-    return SendFrame(FRAME, payload);
+
+    std::lock_guard<std::mutex> lock(pipeMutex_);
+
+    BeginFrame();
+    frameBuffer_ += "{\"cmd\":\"SET_ACTIVITY\",\"args\":{\"activity\":";
+    frameBuffer_ += activity;
+    frameBuffer_ += ",\"pid\":";
+    appendNumber(GetCurrentProcessId());
+    frameBuffer_ += "},\"nonce\":\"";
+    appendNumber(GetTickCount64());
+    frameBuffer_ += "\"}";
+
+    return WriteFrame(FRAME, nullptr);
 }
 
 bool DiscordIPC::IsConnected() const {
     return (pipe_ != INVALID_HANDLE_VALUE);
 }
 
-bool DiscordIPC::SendFrame(int opcode, const json& payload) {
-    std::string data = payload.dump();
-    int32_t length = static_cast<int32_t>(data.size());
+bool DiscordIPC::SendFrame(int opcode, const json& payload, json* response) {
+    std::lock_guard<std::mutex> lock(pipeMutex_);
+
+    BeginFrame();
+    frameBuffer_ += payload.dump();
+
+    return WriteFrame(opcode, response);
+}
+
+void DiscordIPC::BeginFrame() {
+    // Header is filled in by WriteFrame once the payload length is known
+    frameBuffer_.assign(FRAME_HEADER_SIZE, '\0');
+}
+
+bool DiscordIPC::WriteFrame(int opcode, json* response) {
+    int32_t length = static_cast<int32_t>(frameBuffer_.size() - FRAME_HEADER_SIZE);
+    std::memcpy(frameBuffer_.data(), &opcode, sizeof(opcode));
+    std::memcpy(frameBuffer_.data() + 4, &length, sizeof(length));
 
     auto isDisconnectError = [](DWORD err) {
         return err == ERROR_BROKEN_PIPE ||
@@ -81,47 +145,41 @@ bool DiscordIPC::SendFrame(int opcode, const json& payload) {
 
     DWORD written;
 
-    {
-        std::lock_guard<std::mutex> lock(pipeMutex_);
-        if (!WriteFile(pipe_, &opcode, sizeof(opcode), &written, nullptr) || written != sizeof(opcode)) {
-            DWORD err = GetLastError();
-            if (isDisconnectError(err)) Close();
-                return false;
-        }
+    // Header and payload go out in a single write
+    if (!WriteFile(pipe_, frameBuffer_.data(), static_cast<DWORD>(frameBuffer_.size()), &written, nullptr) || written != frameBuffer_.size()) {
+        DWORD err = GetLastError();
+        if (isDisconnectError(err)) Close();
+        return false;
+    }
 
-        if (!WriteFile(pipe_, &length, sizeof(length), &written, nullptr) || written != sizeof(length)) {
-            DWORD err = GetLastError();
-            if (isDisconnectError(err)) Close();
-                return false;
-            }
-
-        if (!WriteFile(pipe_, data.data(), data.size(), &written, nullptr) || written != data.size()) {
-            DWORD err = GetLastError();
-            if (isDisconnectError(err)) Close();
-                return false;
-            }
-        }
+    char header[FRAME_HEADER_SIZE];
+    DWORD read = 0;
 
-        char header[8];
-        DWORD read = 0;
+    if (!ReadFile(pipe_, header, sizeof(header), &read, nullptr) || read != FRAME_HEADER_SIZE) {
+        DWORD err = GetLastError();
+        OutputDebugStringA(("Failed to read header: " + std::to_string(err) + "\n").c_str());
+        if (isDisconnectError(err)) Close();
+        return false;
+    }
 
-        if (!ReadFile(pipe_, header, sizeof(header), &read, nullptr) || read != 8) {
-            DWORD err = GetLastError();
-            OutputDebugStringA(("Failed to read header: " + std::to_string(err) + "\n").c_str());
-            if (isDisconnectError(err)) Close();
-            return false;
-        }
+    int32_t respOp = *reinterpret_cast<int32_t*>(header);
+    int32_t respLen = *reinterpret_cast<int32_t*>(header + 4);
+    if (respLen < 0) {
+        Close();
+        return false;
+    }
 
-        int32_t respOp = *reinterpret_cast<int32_t*>(header);
-        int32_t respLen = *reinterpret_cast<int32_t*>(header + 4);
+    responseBuffer_.resize(respLen);
+    if (!ReadFile(pipe_, responseBuffer_.data(), respLen, &read, nullptr) || read != respLen) {
+        DWORD err = GetLastError();
+        OutputDebugStringA(("Failed to read response: " + std::to_string(err) + "\n").c_str());
+        if (isDisconnectError(err)) Close();
+        return false;
+    }
 
-        std::string responseBuf(respLen, '\0');
-        if (!ReadFile(pipe_, responseBuf.data(), respLen, &read, nullptr) || read != respLen) {
-            DWORD err = GetLastError();
-            OutputDebugStringA(("Failed to read response: " + std::to_string(err) + "\n").c_str());
-            if (isDisconnectError(err)) Close();
-            return false;
-        }
+    if (response) {
+        *response = json::parse(responseBuffer_, nullptr, false);
+    }
 
     return true;
-}
\ No newline at end of file
+}
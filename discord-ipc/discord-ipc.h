@@ -2,7 +2,9 @@
 
 #include <windows.h>
 #include <string>
+#include <string_view>
 #include <mutex>
+#include <atomic>
 
 #include <nlohmann/json.hpp>
 using json = nlohmann::json;
@@ -14,7 +16,8 @@ public:
 
     bool Connect();
     void Close();
-    bool SendActivity(const json& activity);
+    // activity must already be a serialized JSON object
+    bool SendActivity(std::string_view activity);
 
 	bool IsConnected() const;
 
@@ -25,6 +28,12 @@ private:
     std::string clientId_;
     std::mutex pipeMutex_;
 
+    // Reused across frames so steady-state sends don't allocate
+    std::string frameBuffer_;
+    std::string responseBuffer_;
+
     bool SendHandshake();
-    bool SendFrame(int opcode, const json& payload);
+    bool SendFrame(int opcode, const json& payload, json* response = nullptr);
+    void BeginFrame();
+    bool WriteFrame(int opcode, json* response);
 };
\ No newline at end of file
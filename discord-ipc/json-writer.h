@@ -0,0 +1,97 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+
+// Minimal streaming JSON writer that appends straight into an existing string
+// (std::string or std::pmr::string), so payloads can be built without a DOM.
+template <typename Out>
+class JsonWriter {
+public:
+    explicit JsonWriter(Out& out) : m_out(out) {}
+
+    void BeginObject() { BeginScope('{'); }
+    void EndObject() { EndScope('}'); }
+    void BeginArray() { BeginScope('['); }
+    void EndArray() { EndScope(']'); }
+
+    void Key(std::string_view key) {
+        Separate();
+        AppendEscaped(key);
+        m_out += ':';
+        m_afterKey = true;
+    }
+
+    void String(std::string_view value) {
+        Separate();
+        AppendEscaped(value);
+    }
+
+    void Int(int64_t value) {
+        Separate();
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        m_out.append(digits, result.ptr - digits);
+    }
+
+private:
+    static constexpr int MaxDepth = 16;
+
+    Out& m_out;
+    bool m_hasValue[MaxDepth] = {};
+    int m_depth = 0;
+    bool m_afterKey = false;
+
+    void Separate() {
+        if (m_afterKey) {
+            m_afterKey = false;
+            return;
+        }
+        if (m_depth == 0 || m_depth > MaxDepth) return;
+
+        if (m_hasValue[m_depth - 1]) {
+            m_out += ',';
+        }
+        m_hasValue[m_depth - 1] = true;
+    }
+
+    void BeginScope(char open) {
+        Separate();
+        m_out += open;
+        if (m_depth < MaxDepth) {
+            m_hasValue[m_depth] = false;
+        }
+        ++m_depth;
+    }
+
+    void EndScope(char close) {
+        if (m_depth > 0) --m_depth;
+        m_out += close;
+    }
+
+    void AppendEscaped(std::string_view value) {
+        static const char hex[] = "0123456789abcdef";
+
+        m_out += '"';
+        for (char c : value) {
+            switch (c) {
+            case '"': m_out += "\\\""; break;
+            case '\\': m_out += "\\\\"; break;
+            case '\n': m_out += "\\n"; break;
+            case '\r': m_out += "\\r"; break;
+            case '\t': m_out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    m_out += "\\u00";
+                    m_out += hex[(c >> 4) & 0xF];
+                    m_out += hex[c & 0xF];
+                }
+                else {
+                    m_out += c;
+                }
+            }
+        }
+        m_out += '"';
+    }
+};
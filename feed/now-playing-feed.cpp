@@ -0,0 +1,125 @@
+#include "now-playing-feed.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string_view>
+
+// Copies as much of utf8 as fits into dst (NUL-terminated), backing off to the start of a UTF-8 sequence
+static void CopyTruncatedUtf8(std::string_view utf8, char* dst, size_t capacity) {
+    size_t length = (std::min)(utf8.size(), capacity - 1);
+    while (length > 0 && length < utf8.size() && (utf8[length] & 0xC0) == 0x80) --length;
+
+    if (length > 0) memcpy(dst, utf8.data(), length);
+    dst[length] = '\0';
+}
+
+// Writes as much of wide as fits into dst (NUL-terminated), never splitting a character. Every UTF-16 unit
+// becomes at least one byte, so only the first capacity - 1 units can matter; those are converted once into a
+// stack buffer (at most 3 bytes per unit) and the result is cut at a code-point boundary.
+static void CopyUtf8(const std::wstring& wide, char* dst, size_t capacity) {
+    char utf8[3 * AMRP_FEED_URL_SIZE];
+
+    size_t units = (std::min)({ wide.size(), capacity - 1, sizeof(utf8) / 3 });
+    if (units > 0 && units < wide.size() && IS_HIGH_SURROGATE(wide[units - 1])) --units;
+
+    int written = units > 0
+        ? WideCharToMultiByte(CP_UTF8, 0, wide.data(), static_cast<int>(units), utf8, static_cast<int>(sizeof(utf8)), nullptr, nullptr)
+        : 0;
+
+    CopyTruncatedUtf8(std::string_view(utf8, written > 0 ? written : 0), dst, capacity);
+}
+
+static void CopyUtf8(const std::optional<std::string>& utf8, char* dst, size_t capacity) {
+    CopyTruncatedUtf8(utf8 ? std::string_view(*utf8) : std::string_view(), dst, capacity);
+}
+
+static int64_t UnixMs(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+NowPlayingFeed::~NowPlayingFeed() {
+    Close();
+}
+
+bool NowPlayingFeed::Open(const wchar_t* name) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    if (m_feed) return true;
+
+    m_mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(amrp_feed), name);
+    if (!m_mapping) {
+        OutputDebugStringA(("NowPlayingFeed: CreateFileMapping failed (" + std::to_string(GetLastError()) + ").\n").c_str());
+        return false;
+    }
+
+    m_feed = static_cast<amrp_feed*>(MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, sizeof(amrp_feed)));
+    if (!m_feed) {
+        OutputDebugStringA("NowPlayingFeed: MapViewOfFile failed.\n");
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+        return false;
+    }
+
+    // Readers check magic/version before trusting the layout
+    m_feed->version = AMRP_FEED_VERSION;
+    InterlockedExchange(reinterpret_cast<volatile LONG*>(&m_feed->magic), static_cast<LONG>(AMRP_FEED_MAGIC));
+    return true;
+}
+
+void NowPlayingFeed::Close() {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+
+    if (m_feed) {
+        UnmapViewOfFile(m_feed);
+        m_feed = nullptr;
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+}
+
+void NowPlayingFeed::BeginWrite() {
+    // Odd sequence: readers retry. The interlocked op orders it before the data stores.
+    InterlockedIncrement64(&m_feed->sequence);
+}
+
+void NowPlayingFeed::EndWrite() {
+    InterlockedIncrement64(&m_feed->sequence);
+}
+
+void NowPlayingFeed::Publish(const PlayerInfo& info, uint64_t update) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    if (!m_feed || update < m_lastUpdate || (update == m_lastUpdate && m_cleared)) return;
+    m_lastUpdate = update;
+    m_cleared = false;
+
+    BeginWrite();
+
+    amrp_now_playing& data = m_feed->data;
+    data.status = static_cast<uint32_t>(info.playbackStatus);
+    data.position_ms = std::chrono::duration_cast<std::chrono::milliseconds>(info.position).count();
+    data.duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(info.duration).count();
+    data.start_time_ms = info.startTime.time_since_epoch().count() != 0 ? UnixMs(info.startTime) : 0;
+    data.updated_at_ms = UnixMs(std::chrono::system_clock::now());
+
+    CopyUtf8(info.title, data.title, AMRP_FEED_TEXT_SIZE);
+    CopyUtf8(info.artist, data.artist, AMRP_FEED_TEXT_SIZE);
+    CopyUtf8(info.albumTitle, data.album, AMRP_FEED_TEXT_SIZE);
+    CopyUtf8(info.thumbnailUrl, data.artwork_url, AMRP_FEED_URL_SIZE);
+    CopyUtf8(info.albumUrl, data.album_url, AMRP_FEED_URL_SIZE);
+
+    EndWrite();
+}
+
+void NowPlayingFeed::Clear() {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    if (!m_feed) return;
+
+    m_cleared = true;
+
+    BeginWrite();
+    memset(&m_feed->data, 0, sizeof(m_feed->data));
+    m_feed->data.status = AMRP_STATUS_CLOSED;
+    m_feed->data.updated_at_ms = UnixMs(std::chrono::system_clock::now());
+    EndWrite();
+}
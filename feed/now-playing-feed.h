@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+#include "now-playing.h"
+#include "../player/player-types.h"
+
+// Writer side of the shared-memory now-playing feed (layout and reader in now-playing.h).
+// Readers poll the region lock-free; the seqlock sequence is odd while a write is in progress.
+class NowPlayingFeed {
+public:
+    NowPlayingFeed() = default;
+    ~NowPlayingFeed();
+
+    NowPlayingFeed(const NowPlayingFeed&) = delete;
+    NowPlayingFeed& operator=(const NowPlayingFeed&) = delete;
+
+    // name is only overridden by tests, so they never write into a running app's feed
+    bool Open(const wchar_t* name = AMRP_FEED_NAME);
+    void Close();
+
+    // Fixed-size fields, so publishing never allocates. update is the presence update's sequence: the same
+    // update may be published again once its artwork resolves, but never over a newer one.
+    void Publish(const PlayerInfo& info, uint64_t update);
+
+    // Marks the feed as having no session, until a newer update is published
+    void Clear();
+
+private:
+    std::mutex m_writeMutex;
+    HANDLE m_mapping = nullptr;
+    amrp_feed* m_feed = nullptr;
+    uint64_t m_lastUpdate = 0;
+    bool m_cleared = false; // Keeps a late artwork republish from reopening a cleared feed
+
+    void BeginWrite();
+    void EndWrite();
+};
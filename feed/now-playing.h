@@ -0,0 +1,116 @@
+/*
+ * Now-playing feed published by Apple Music Rich Presence.
+ *
+ * Plain C, header-only: copy this file into an overlay or widget to read the
+ * current track. The app owns a named, read-only-to-you shared memory region
+ * guarded by a seqlock, so readers never make a syscall after opening it and
+ * never write to memory the publisher touches.
+ *
+ *     HANDLE mapping;
+ *     const amrp_feed* feed = amrp_feed_open(&mapping);
+ *     amrp_now_playing now;
+ *     if (feed && amrp_feed_read(feed, &now) && now.status == AMRP_STATUS_PLAYING) { ... }
+ *     amrp_feed_close(feed, mapping);
+ */
+#pragma once
+
+#include <windows.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AMRP_FEED_NAME L"Local\\AppleMusicRichPresence.NowPlaying"
+#define AMRP_FEED_MAGIC 0x504E4D41u /* "AMNP" */
+#define AMRP_FEED_VERSION 1u
+
+#define AMRP_FEED_TEXT_SIZE 512
+#define AMRP_FEED_URL_SIZE 1024
+
+/* Mirrors GlobalSystemMediaTransportControlsSessionPlaybackStatus */
+#define AMRP_STATUS_CLOSED 0u
+#define AMRP_STATUS_OPENED 1u
+#define AMRP_STATUS_CHANGING 2u
+#define AMRP_STATUS_STOPPED 3u
+#define AMRP_STATUS_PLAYING 4u
+#define AMRP_STATUS_PAUSED 5u
+
+/* Strings are UTF-8 and always NUL-terminated; over-long values are cut at a character boundary. */
+typedef struct amrp_now_playing {
+    uint32_t status;
+    uint32_t reserved;
+    int64_t position_ms;
+    int64_t duration_ms;
+    int64_t start_time_ms;   /* Unix ms the track started, 0 if unknown; extrapolate position from it while playing */
+    int64_t updated_at_ms;   /* Unix ms of the last write */
+    char title[AMRP_FEED_TEXT_SIZE];
+    char artist[AMRP_FEED_TEXT_SIZE];
+    char album[AMRP_FEED_TEXT_SIZE];
+    char artwork_url[AMRP_FEED_URL_SIZE];
+    char album_url[AMRP_FEED_URL_SIZE];
+} amrp_now_playing;
+
+typedef struct amrp_feed {
+    uint32_t magic;
+    uint32_t version;
+    volatile LONG64 sequence; /* Odd while the publisher is writing */
+    amrp_now_playing data;
+} amrp_feed;
+
+/* Returns NULL when the app is not running or the layout is unknown. */
+static __inline const amrp_feed* amrp_feed_open_named(const wchar_t* name, HANDLE* mapping) {
+    const amrp_feed* feed;
+
+    *mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, name);
+    if (!*mapping) return NULL;
+
+    feed = (const amrp_feed*)MapViewOfFile(*mapping, FILE_MAP_READ, 0, 0, sizeof(amrp_feed));
+    if (!feed || feed->magic != AMRP_FEED_MAGIC || feed->version != AMRP_FEED_VERSION) {
+        if (feed) UnmapViewOfFile(feed);
+        CloseHandle(*mapping);
+        *mapping = NULL;
+        return NULL;
+    }
+    return feed;
+}
+
+static __inline const amrp_feed* amrp_feed_open(HANDLE* mapping) {
+    return amrp_feed_open_named(AMRP_FEED_NAME, mapping);
+}
+
+static __inline void amrp_feed_close(const amrp_feed* feed, HANDLE mapping) {
+    if (feed) UnmapViewOfFile(feed);
+    if (mapping) CloseHandle(mapping);
+}
+
+/* Copies a consistent snapshot into out. Returns 0 if the publisher kept writing through every attempt. */
+static __inline int amrp_feed_read(const amrp_feed* feed, amrp_now_playing* out) {
+    int attempt;
+    for (attempt = 0; attempt < 64; ++attempt) {
+        LONG64 before = ReadAcquire64((LONG64 const volatile*)&feed->sequence);
+        if (before & 1) {
+            YieldProcessor();
+            continue;
+        }
+
+        memcpy(out, (const void*)&feed->data, sizeof(*out));
+
+        /* The copy must complete before the sequence is read again */
+        MemoryBarrier();
+        if (ReadNoFence64((LONG64 const volatile*)&feed->sequence) == before) {
+            out->title[AMRP_FEED_TEXT_SIZE - 1] = '\0';
+            out->artist[AMRP_FEED_TEXT_SIZE - 1] = '\0';
+            out->album[AMRP_FEED_TEXT_SIZE - 1] = '\0';
+            out->artwork_url[AMRP_FEED_URL_SIZE - 1] = '\0';
+            out->album_url[AMRP_FEED_URL_SIZE - 1] = '\0';
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,381 @@
+#include "listening-history.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "../strings/string-utils.h"
+
+#define HISTORY_SEGMENT_BYTES (RecordsPerSegment * sizeof(HistoryRecord))
+
+void ListeningHistory::SegmentView::Close() {
+    if (records) {
+        UnmapViewOfFile(records);
+        records = nullptr;
+    }
+    if (mapping) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+    }
+}
+
+ListeningHistory::~ListeningHistory() {
+    Close();
+}
+
+uint32_t ListeningHistory::Checksum(const HistoryRecord& record) {
+    // FNV-1a over every field but the checksum itself
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&record);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(HistoryRecord, checksum); ++i) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool ListeningHistory::IsValid(const HistoryRecord& record) {
+    return record.startedAtMs != 0 && record.checksum == Checksum(record);
+}
+
+uint32_t ListeningHistory::CountValid(const HistoryRecord* records) {
+    // Scan rather than binary search: after a power loss a later page can be on disk without an earlier one,
+    // so a valid record past a hole proves nothing. Everything from the first bad record on is overwritten.
+    uint32_t count = 0;
+    while (count < RecordsPerSegment && IsValid(records[count])) {
+        ++count;
+    }
+    return count;
+}
+
+uint64_t ListeningHistory::ToMs(TimePoint time) {
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+    return ms > 0 ? static_cast<uint64_t>(ms) : 0;
+}
+
+std::wstring ListeningHistory::SegmentPath(uint32_t index) const {
+    wchar_t name[32];
+    swprintf_s(name, L"history-%06u.seg", index);
+    return m_directory + L"\\" + name;
+}
+
+bool ListeningHistory::MapSegment(uint32_t index, bool writable, SegmentView& view) const {
+    std::wstring path = SegmentPath(index);
+
+    view.file = CreateFileW(path.c_str(),
+        writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+        writable ? OPEN_ALWAYS : OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (view.file == INVALID_HANDLE_VALUE) return false;
+
+    // Segments are preallocated; unwritten slots read back as zeros and fail validation
+    view.mapping = CreateFileMappingW(view.file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+        0, static_cast<DWORD>(HISTORY_SEGMENT_BYTES), nullptr);
+    if (!view.mapping) {
+        view.Close();
+        return false;
+    }
+
+    view.records = static_cast<HistoryRecord*>(MapViewOfFile(view.mapping,
+        writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, HISTORY_SEGMENT_BYTES));
+    if (!view.records) {
+        view.Close();
+        return false;
+    }
+
+    return true;
+}
+
+bool ListeningHistory::OpenActiveSegment(uint32_t index) {
+    m_active.Close();
+    if (!MapSegment(index, true, m_active)) {
+        OutputDebugStringA(("ListeningHistory: failed to map segment: " + std::to_string(GetLastError()) + "\n").c_str());
+        return false;
+    }
+
+    if (m_segments.empty() || m_segments.back().index != index) {
+        Segment segment;
+        segment.index = index;
+        m_segments.push_back(segment);
+    }
+    return true;
+}
+
+bool ListeningHistory::LoadStrings() {
+    std::wstring path = m_directory + L"\\strings.dat";
+    m_stringsFile = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+        OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_stringsFile == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size{};
+    GetFileSizeEx(m_stringsFile, &size);
+
+    std::string data(static_cast<size_t>(size.QuadPart), '\0');
+    DWORD read = 0;
+    if (!data.empty() && !ReadFile(m_stringsFile, data.data(), static_cast<DWORD>(data.size()), &read, nullptr)) {
+        return false;
+    }
+    data.resize(read);
+
+    // Entries are [uint32 length][utf8]; a torn entry at the tail is cut off
+    size_t offset = 0;
+    while (offset + sizeof(uint32_t) <= data.size()) {
+        uint32_t length = 0;
+        memcpy(&length, data.data() + offset, sizeof(length)); // Entries are not aligned
+        if (offset + sizeof(uint32_t) + length > data.size()) break;
+
+        std::wstring value = UTF8ToWide(std::string_view(data.data() + offset + sizeof(uint32_t), length));
+        m_stringIds.emplace(value, static_cast<uint32_t>(m_strings.size()));
+        m_strings.push_back(std::move(value));
+
+        offset += sizeof(uint32_t) + length;
+    }
+
+    LARGE_INTEGER end{};
+    end.QuadPart = static_cast<LONGLONG>(offset);
+    SetFilePointerEx(m_stringsFile, end, nullptr, FILE_BEGIN);
+    SetEndOfFile(m_stringsFile);
+    m_stringsSize = offset;
+
+    return true;
+}
+
+std::optional<uint32_t> ListeningHistory::Intern(const std::wstring& value) {
+    auto it = m_stringIds.find(value);
+    if (it != m_stringIds.end()) return it->second;
+
+    std::string utf8 = WideToUTF8(value);
+    std::string entry(sizeof(uint32_t), '\0');
+    uint32_t length = static_cast<uint32_t>(utf8.size());
+    memcpy(entry.data(), &length, sizeof(length));
+    entry += utf8;
+
+    // The string must be durable before any record refers to its id. A failed or short write is cut back
+    // off the file, since a torn entry in the middle would shift the ids of every entry after it.
+    DWORD written = 0;
+    bool durable = WriteFile(m_stringsFile, entry.data(), static_cast<DWORD>(entry.size()), &written, nullptr)
+        && written == entry.size()
+        && FlushFileBuffers(m_stringsFile);
+    if (!durable) {
+        OutputDebugStringA("ListeningHistory: failed to write string table entry.\n");
+
+        LARGE_INTEGER end{};
+        end.QuadPart = static_cast<LONGLONG>(m_stringsSize);
+        SetFilePointerEx(m_stringsFile, end, nullptr, FILE_BEGIN);
+        SetEndOfFile(m_stringsFile);
+        return std::nullopt;
+    }
+    m_stringsSize += entry.size();
+
+    uint32_t id = static_cast<uint32_t>(m_strings.size());
+    m_strings.push_back(value);
+    m_stringIds.emplace(value, id);
+    return id;
+}
+
+bool ListeningHistory::Open(const std::wstring& directory) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_directory = directory;
+    CreateDirectoryW(m_directory.c_str(), nullptr);
+
+    if (!LoadStrings()) {
+        OutputDebugStringA("ListeningHistory: failed to open string table.\n");
+        return false;
+    }
+
+    // Index the segments by count and first/last timestamps without reading their bodies
+    WIN32_FIND_DATAW findData;
+    HANDLE find = FindFirstFileW((m_directory + L"\\history-*.seg").c_str(), &findData);
+    if (find != INVALID_HANDLE_VALUE) {
+        do {
+            unsigned int index = 0;
+            if (swscanf_s(findData.cFileName, L"history-%u.seg", &index) == 1) {
+                Segment segment;
+                segment.index = index;
+                m_segments.push_back(segment);
+            }
+        } while (FindNextFileW(find, &findData));
+        FindClose(find);
+    }
+
+    std::sort(m_segments.begin(), m_segments.end(), [](const Segment& a, const Segment& b) { return a.index < b.index; });
+
+    for (auto& segment : m_segments) {
+        SegmentView view;
+        if (!MapSegment(segment.index, false, view)) continue;
+
+        segment.count = CountValid(view.records);
+        if (segment.count > 0) {
+            segment.firstMs = view.records[0].startedAtMs;
+            segment.lastMs = view.records[segment.count - 1].startedAtMs;
+        }
+        view.Close();
+    }
+
+    uint32_t activeIndex = m_segments.empty() ? 0 : m_segments.back().index;
+    if (!m_segments.empty() && m_segments.back().count >= RecordsPerSegment) {
+        ++activeIndex;
+    }
+
+    if (!OpenActiveSegment(activeIndex)) return false;
+
+    // Records past the recovered prefix are torn or outlived a lost one before them. Clear them, or an append
+    // that fills the hole would make them contiguous again on the next open.
+    const Segment& active = m_segments.back();
+    const HistoryRecord empty{};
+    for (uint32_t i = active.count; i < RecordsPerSegment; ++i) {
+        if (memcmp(&m_active.records[i], &empty, sizeof(HistoryRecord)) != 0) {
+            HistoryRecord* tail = &m_active.records[active.count];
+            size_t tailBytes = static_cast<size_t>(RecordsPerSegment - active.count) * sizeof(HistoryRecord);
+            memset(tail, 0, tailBytes);
+            FlushViewOfFile(tail, tailBytes);
+            FlushFileBuffers(m_active.file);
+            break;
+        }
+    }
+
+    return true;
+}
+
+void ListeningHistory::Close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_active.records) {
+        FlushViewOfFile(m_active.records, 0);
+    }
+    m_active.Close();
+
+    if (m_stringsFile != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_stringsFile);
+        m_stringsFile = INVALID_HANDLE_VALUE;
+    }
+
+    m_segments.clear();
+    m_strings.clear();
+    m_stringsSize = 0;
+    m_stringIds.clear();
+}
+
+bool ListeningHistory::Append(const PlayRecord& play) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_active.records || m_segments.empty()) return false;
+
+    Segment* segment = &m_segments.back();
+    if (segment->count >= RecordsPerSegment) {
+        if (!OpenActiveSegment(segment->index + 1)) return false;
+        segment = &m_segments.back();
+    }
+
+    // A record is only written once every id it refers to is on disk
+    auto artistId = Intern(play.artist);
+    auto albumId = artistId ? Intern(play.albumTitle) : std::nullopt;
+    auto titleId = albumId ? Intern(play.title) : std::nullopt;
+    if (!titleId) return false;
+
+    HistoryRecord record{};
+    record.startedAtMs = ToMs(play.startedAt);
+    record.playedSeconds = static_cast<uint32_t>(play.played.count());
+    record.durationSeconds = static_cast<uint32_t>(play.duration.count());
+    record.artistId = *artistId;
+    record.albumId = *albumId;
+    record.titleId = *titleId;
+    record.checksum = Checksum(record);
+
+    // FlushViewOfFile only queues the dirty page; FlushFileBuffers waits for it to reach the disk, so records
+    // become durable in append order
+    HistoryRecord* slot = &m_active.records[segment->count];
+    *slot = record;
+    if (!FlushViewOfFile(slot, sizeof(HistoryRecord)) || !FlushFileBuffers(m_active.file)) {
+        OutputDebugStringA("ListeningHistory: failed to flush record.\n");
+    }
+
+    if (segment->count == 0) segment->firstMs = record.startedAtMs;
+    segment->lastMs = record.startedAtMs;
+    ++segment->count;
+
+    return true;
+}
+
+void ListeningHistory::ForEach(TimePoint from, TimePoint to, const std::function<void(const HistoryRecord&)>& visitor) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ForEachLocked(ToMs(from), ToMs(to), visitor);
+}
+
+void ListeningHistory::ForEachLocked(uint64_t fromMs, uint64_t toMs, const std::function<void(const HistoryRecord&)>& visitor) {
+    for (const auto& segment : m_segments) {
+        if (segment.count == 0 || segment.lastMs < fromMs || segment.firstMs >= toMs) continue;
+
+        SegmentView view;
+        const HistoryRecord* records = nullptr;
+        if (!m_segments.empty() && segment.index == m_segments.back().index && m_active.records) {
+            records = m_active.records;
+        }
+        else {
+            if (!MapSegment(segment.index, false, view)) continue;
+            records = view.records;
+        }
+
+        // Records are appended in time order, so seek to the window start
+        const HistoryRecord* begin = std::lower_bound(records, records + segment.count, fromMs,
+            [](const HistoryRecord& record, uint64_t value) { return record.startedAtMs < value; });
+
+        for (const HistoryRecord* it = begin; it != records + segment.count && it->startedAtMs < toMs; ++it) {
+            visitor(*it);
+        }
+
+        view.Close();
+    }
+}
+
+std::vector<ArtistPlays> ListeningHistory::TopArtists(TimePoint from, TimePoint to, size_t count) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::unordered_map<uint32_t, std::pair<uint32_t, uint64_t>> totals;
+    ForEachLocked(ToMs(from), ToMs(to), [&](const HistoryRecord& record) {
+        auto& total = totals[record.artistId];
+        total.first += 1;
+        total.second += record.playedSeconds;
+        });
+
+    std::vector<std::pair<uint32_t, std::pair<uint32_t, uint64_t>>> ranked(totals.begin(), totals.end());
+    count = (std::min)(count, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(), [](const auto& a, const auto& b) {
+        return a.second.first != b.second.first ? a.second.first > b.second.first : a.second.second > b.second.second;
+        });
+
+    std::vector<ArtistPlays> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        ArtistPlays plays;
+        plays.artist = ranked[i].first < m_strings.size() ? m_strings[ranked[i].first] : std::wstring{};
+        plays.plays = ranked[i].second.first;
+        plays.played = std::chrono::seconds(ranked[i].second.second);
+        result.push_back(std::move(plays));
+    }
+    return result;
+}
+
+uint32_t ListeningHistory::PlaysForArtist(const std::wstring& artist, TimePoint from, TimePoint to) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_stringIds.find(artist);
+    if (it == m_stringIds.end()) return 0;
+
+    uint32_t artistId = it->second;
+    uint32_t plays = 0;
+    ForEachLocked(ToMs(from), ToMs(to), [&](const HistoryRecord& record) {
+        if (record.artistId == artistId) ++plays;
+        });
+    return plays;
+}
+
+std::wstring ListeningHistory::Lookup(uint32_t id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return id < m_strings.size() ? m_strings[id] : std::wstring{};
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <windows.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../player/play-tracker.h"
+
+#pragma pack(push, 1)
+// Fixed-size record; checksum covers the preceding fields so torn writes are detected on recovery
+struct HistoryRecord {
+    uint64_t startedAtMs;
+    uint32_t playedSeconds;
+    uint32_t durationSeconds;
+    uint32_t artistId;
+    uint32_t albumId;
+    uint32_t titleId;
+    uint32_t checksum;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(HistoryRecord) == 32, "HistoryRecord must stay 32 bytes");
+
+struct ArtistPlays {
+    std::wstring artist;
+    uint32_t plays = 0;
+    std::chrono::seconds played{};
+};
+
+// Durable listening history made of append-only, memory-mapped segment files
+// (history-NNNNNN.seg) plus an append-only string table (strings.dat) that
+// interns artist, album and title names to 32-bit ids.
+class ListeningHistory {
+public:
+    using TimePoint = std::chrono::system_clock::time_point;
+
+    ListeningHistory() = default;
+    ~ListeningHistory();
+
+    ListeningHistory(const ListeningHistory&) = delete;
+    ListeningHistory& operator=(const ListeningHistory&) = delete;
+
+    bool Open(const std::wstring& directory);
+    void Close();
+
+    bool Append(const PlayRecord& play);
+
+    // Visits records with startedAt in [from, to) in append order, one segment mapped at a time
+    void ForEach(TimePoint from, TimePoint to, const std::function<void(const HistoryRecord&)>& visitor);
+
+    std::vector<ArtistPlays> TopArtists(TimePoint from, TimePoint to, size_t count);
+    uint32_t PlaysForArtist(const std::wstring& artist, TimePoint from, TimePoint to);
+
+    std::wstring Lookup(uint32_t id);
+
+private:
+    static constexpr uint32_t RecordsPerSegment = 32768;
+
+    struct Segment {
+        uint32_t index = 0;
+        uint32_t count = 0;
+        uint64_t firstMs = 0;
+        uint64_t lastMs = 0;
+    };
+
+    struct SegmentView {
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+        HistoryRecord* records = nullptr;
+
+        void Close();
+    };
+
+    std::mutex m_mutex;
+    std::wstring m_directory;
+
+    std::vector<Segment> m_segments;
+    SegmentView m_active;
+
+    HANDLE m_stringsFile = INVALID_HANDLE_VALUE;
+    uint64_t m_stringsSize = 0; // End of the last complete entry
+    std::vector<std::wstring> m_strings;
+    std::unordered_map<std::wstring, uint32_t> m_stringIds;
+
+    std::wstring SegmentPath(uint32_t index) const;
+    bool MapSegment(uint32_t index, bool writable, SegmentView& view) const;
+    bool OpenActiveSegment(uint32_t index);
+    bool LoadStrings();
+    // Nothing if the entry could not be made durable; the table is left as it was
+    std::optional<uint32_t> Intern(const std::wstring& value);
+    void ForEachLocked(uint64_t fromMs, uint64_t toMs, const std::function<void(const HistoryRecord&)>& visitor);
+
+    static uint32_t Checksum(const HistoryRecord& record);
+    static bool IsValid(const HistoryRecord& record);
+    static uint32_t CountValid(const HistoryRecord* records);
+    static uint64_t ToMs(TimePoint time);
+};
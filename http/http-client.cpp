@@ -0,0 +1,59 @@
+#include "http-client.h"
+
+#include <windows.h>
+
+#include <winrt/Windows.Foundation.h>
+#include <winrt/Windows.Storage.Streams.h>
+#include <winrt/Windows.Web.Http.h>
+#include <winrt/Windows.Web.Http.Headers.h>
+
+static winrt::Windows::Web::Http::HttpClient& SharedClient() {
+    // One client for the whole process so connections are pooled
+    static winrt::Windows::Web::Http::HttpClient client;
+    return client;
+}
+
+Task<std::string> HttpGetAsync(std::wstring url) {
+    try {
+        winrt::Windows::Foundation::Uri uri{ url };
+        winrt::hstring body = co_await SharedClient().GetStringAsync(uri);
+        co_return winrt::to_string(body);
+    }
+    catch (const winrt::hresult_error& e) {
+        OutputDebugStringA(("HttpGetAsync failed: " + winrt::to_string(e.message()) + "\n").c_str());
+    }
+
+    co_return std::string{};
+}
+
+Task<int> HttpPostJsonAsync(std::wstring url, std::string body, std::wstring authorization, HttpCancellation* cancellation) {
+    using namespace winrt::Windows::Web::Http;
+
+    int status = 0;
+    try {
+        HttpRequestMessage request(HttpMethod::Post(), winrt::Windows::Foundation::Uri{ url });
+        request.Content(HttpStringContent(winrt::to_hstring(body), winrt::Windows::Storage::Streams::UnicodeEncoding::Utf8, L"application/json"));
+        if (!authorization.empty()) {
+            request.Headers().TryAppendWithoutValidation(L"Authorization", authorization);
+        }
+
+        auto operation = SharedClient().SendRequestAsync(request);
+        if (cancellation) {
+            cancellation->Attach([operation] { operation.Cancel(); });
+        }
+
+        HttpResponseMessage response = co_await operation;
+        status = static_cast<int>(response.StatusCode());
+    }
+    catch (const winrt::hresult_canceled&) {
+        OutputDebugStringA("HttpPostJsonAsync cancelled.\n");
+    }
+    catch (const winrt::hresult_error& e) {
+        OutputDebugStringA(("HttpPostJsonAsync failed: " + winrt::to_string(e.message()) + "\n").c_str());
+    }
+
+    if (cancellation) {
+        cancellation->Detach();
+    }
+    co_return status;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include "../async/task.h"
+
+// Lets another thread abort a request in flight. Once cancelled, the current request and every later one
+// started with this token complete immediately as failed.
+class HttpCancellation {
+public:
+    void Cancel() {
+        std::function<void()> cancel;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_cancelled = true;
+            cancel = std::move(m_cancel);
+        }
+        if (cancel) cancel();
+    }
+
+    void Reset() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cancelled = false;
+    }
+
+    // Used by the request functions to register (and drop) the abort for the request in flight
+    void Attach(std::function<void()> cancel) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_cancelled) {
+                m_cancel = std::move(cancel);
+                return;
+            }
+        }
+        cancel();
+    }
+
+    void Detach() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cancel = nullptr;
+    }
+
+private:
+    std::mutex m_mutex;
+    bool m_cancelled = false;
+    std::function<void()> m_cancel;
+};
+
+// Fetches url and returns the body as UTF-8, or an empty string on failure.
+// The calling coroutine is suspended while the request is in flight.
+Task<std::string> HttpGetAsync(std::wstring url);
+
+// POSTs a UTF-8 JSON body and returns the HTTP status code, or 0 if the request never completed or was cancelled.
+// authorization, when non-empty, is sent verbatim as the Authorization header.
+Task<int> HttpPostJsonAsync(std::wstring url, std::string body, std::wstring authorization = {}, HttpCancellation* cancellation = nullptr);
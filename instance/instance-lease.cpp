@@ -0,0 +1,50 @@
+#include "instance-lease.h"
+
+InstanceLease::InstanceLease(std::wstring name)
+    : m_name(std::move(name)) {
+}
+
+InstanceLease::~InstanceLease() {
+    Release();
+
+    if (m_mutex) {
+        CloseHandle(m_mutex);
+        m_mutex = nullptr;
+    }
+}
+
+bool InstanceLease::TryAcquire() {
+    if (m_held) return true;
+
+    if (!m_mutex) {
+        m_mutex = CreateMutexW(nullptr, FALSE, m_name.c_str());
+        if (!m_mutex) {
+            OutputDebugStringA(("InstanceLease: CreateMutex failed (" + std::to_string(GetLastError()) + ").\n").c_str());
+            return false;
+        }
+    }
+
+    switch (WaitForSingleObject(m_mutex, 0)) {
+    case WAIT_OBJECT_0:
+        m_held = true;
+        break;
+
+    case WAIT_ABANDONED:
+        // Previous holder exited without releasing; its state files are written atomically, so just take over
+        OutputDebugStringA("InstanceLease: previous publisher died, taking over.\n");
+        m_held = true;
+        break;
+
+    default:
+        break;
+    }
+
+    return m_held;
+}
+
+void InstanceLease::Release() {
+    if (!m_held) return;
+
+    ReleaseMutex(m_mutex);
+    m_held = false;
+}
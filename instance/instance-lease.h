@@ -0,0 +1,27 @@
+#pragma once
+
+#include <windows.h>
+#include <string>
+
+// Publisher lease held through a named mutex. Only the holder subscribes to SMTC and talks to Discord.
+// The kernel releases the mutex when the holder's process dies, so the next launch takes over at once
+// instead of waiting on a stale lock file.
+class InstanceLease {
+public:
+    explicit InstanceLease(std::wstring name);
+    ~InstanceLease();
+
+    InstanceLease(const InstanceLease&) = delete;
+    InstanceLease& operator=(const InstanceLease&) = delete;
+
+    // Non-blocking; must be released on the thread that acquired it
+    bool TryAcquire();
+    void Release();
+
+    bool IsHeld() const { return m_held; }
+
+private:
+    std::wstring m_name;
+    HANDLE m_mutex = nullptr;
+    bool m_held = false;
+};
@@ -7,18 +7,41 @@
 #include <thread>
 #include <chrono>
 #include <iomanip>
+#include <cassert>
 #include <memory>
+#include <memory_resource>
 #include <sstream>
 
 #include <nlohmann/json.hpp>
 
 #include "discord-ipc/discord-ipc.h"
 #include "player/player.h"
+#include "catalog/catalog-index.h"
+#include "history/listening-history.h"
+#include "scrobbler/scrobbler.h"
+#include "feed/now-playing-feed.h"
+#include "instance/instance-lease.h"
+#include "prefetch/artwork-prefetcher.h"
+#include "presence/presence-template.h"
+#include "presence/activity-payload.h"
+#include "storage/app-data.h"
+#include "storage/presence-snapshot.h"
+#include "memory/update-arena.h"
+#include "memory/alloc-counter.h"
+#include "async/executor.h"
+#include "async/task-tracker.h"
+#include "async/task.h"
+#include "async/update-queue.h"
+#include "scheduler/adaptive-scheduler.h"
 
 #include <winrt/Windows.Foundation.h>
 
 #define WM_TRAYICON (WM_USER + 1)
 #define IDM_EXIT 1001
+#define WINDOW_CLASS_NAME L"AppleMusicDiscordRichPresenceAppClass"
+
+// WM_COPYDATA tag for a CSV path handed over by --build-catalog
+#define COPYDATA_CATALOG_IMPORT 0x504D4943 // "CIMP"
 
 // Globals
 static  NOTIFYICONDATA nid = {};
@@ -26,39 +49,106 @@ static  std::atomic<bool> isRunning = false;
 static  std::atomic<bool> isDone = false;
 
 static std::mutex ipcMtx;
-static  std::condition_variable ipcCv;
-static  bool ipcTryConnect = false;
 
+// Imports handed over by --build-catalog run here, off the window thread
+static std::thread catalogImportThread;
+static std::atomic<bool> catalogImportRunning = false;
 
-auto player = std::make_shared<Player>();
-std::shared_ptr<DiscordIPC> discordIpc{ nullptr };
+// Wakes the Init loop; bumped by player state changes, IPC failures and shutdown
+static std::mutex wakeMtx;
+static std::condition_variable wakeCv;
+static uint64_t wakeVersion = 0;
 
-// Utility function
-static std::string WideToUTF8(const std::wstring& wide) {
-    if (wide.empty()) return {};
+// Time-to-first-presence metric, restarted on every new Discord connection
+static std::mutex presenceMetricMtx;
+static std::chrono::steady_clock::time_point presenceClockStart = std::chrono::steady_clock::now();
+static bool presencePending = true;
 
-    int utf8Size = WideCharToMultiByte(CP_UTF8, 0, wide.c_str(), -1, nullptr, 0, nullptr, nullptr);
-    if (utf8Size <= 0) return {};
+// Last presence Discord accepted (guarded by ipcMtx), replayed on reconnect and snapshotted for restarts
+static std::optional<PlayerInfo> lastPresence;
 
-    std::string utf8(utf8Size - 1, '\0');
-    WideCharToMultiByte(CP_UTF8, 0, wide.c_str(), -1, &utf8[0], utf8Size, nullptr, nullptr);
+// Where lastPresence is snapshotted; resolved once by Init before anything can publish
+static std::wstring presenceSnapshotPath;
 
-    return utf8;
-}
+
+// Runs every Discord send so media callbacks never wait on the pipe. Created by Init, so --build-catalog
+// never starts its thread.
+static std::unique_ptr<Executor> ipcExecutor;
+
+// Detached drain/publish coroutines; Init cancels and joins them before tearing down what they use
+static TaskTracker presenceTasks;
+
+// Writes finished plays to the history and scrobble journal. Both fsync, so they stay off the media callback
+// thread and off the IPC executor.
+static std::unique_ptr<Executor> recordExecutor;
+
+// A presence stamped in enqueue order, so a publish that resumes late can tell it has been superseded
+struct PresenceUpdate {
+    uint64_t sequence = 0;
+    PlayerInfo info;
+};
+
+// Media callbacks push here and return; the IPC executor drains it and publishes only the newest entry
+static UpdateQueue<PresenceUpdate, 8> presenceQueue;
+static std::atomic<bool> drainScheduled = false;
+static std::atomic<uint64_t> presenceSequence = 0;
+
+// Sequence of the last update handed to Discord (guarded by ipcMtx); anything at or below it is stale
+static uint64_t lastSentSequence = 0;
+
+// Activity field layouts, compiled from presence-templates.json before the first publish
+static PresenceTemplates presenceTemplates;
+
+// Shared-memory copy of the current track for local overlays
+static NowPlayingFeed nowPlayingFeed;
+
+auto player = std::make_shared<Player>();
+auto catalog = std::make_shared<CatalogIndex>();
+auto history = std::make_shared<ListeningHistory>();
+std::shared_ptr<Scrobbler> scrobbler{ nullptr };
+std::shared_ptr<ArtworkPrefetcher> prefetcher{ nullptr };
+std::shared_ptr<DiscordIPC> discordIpc{ nullptr };
 
 // Forward declarations
 DWORD WINAPI Init(LPVOID);
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+static void WakeScheduler();
+static bool ForwardCatalogImport(HWND target, const wchar_t* csvPath);
+static int RunCatalogImport(const wchar_t* csvPath, bool leaseHeld);
 
 // Main entry point
 int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    // A second copy (autostart plus a manual launch) would double the SMTC and iTunes work and fight
+    // over SET_ACTIVITY, so only the lease holder runs. The holder also owns catalog.idx and its delta log.
+    InstanceLease lease(L"Local\\AppleMusicRichPresence.Publisher");
+    bool leaseHeld = lease.TryAcquire();
+
+    // --build-catalog <export.csv>: merge a library export into the offline catalog index and exit
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (argv) {
+        for (int i = 1; i + 1 < argc; ++i) {
+            if (_wcsicmp(argv[i], L"--build-catalog") == 0) {
+                int result = RunCatalogImport(argv[i + 1], leaseHeld);
+                LocalFree(argv);
+                return result;
+            }
+        }
+        LocalFree(argv);
+    }
+
+    if (!leaseHeld) {
+        OutputDebugStringA("Another instance is already publishing, exiting.\n");
+        return 0;
+    }
+
     winrt::init_apartment(winrt::apartment_type::single_threaded);
 
     // Register window class
     WNDCLASS wc = {};
     wc.lpfnWndProc = WindowProc;
     wc.hInstance = hInstance;
-    wc.lpszClassName = L"AppleMusicDiscordRichPresenceAppClass";
+    wc.lpszClassName = WINDOW_CLASS_NAME;
 
     if (!RegisterClass(&wc)) return 1;
 
@@ -98,6 +188,10 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 
     // Begin cleanup
     isRunning.store(false);
+    WakeScheduler();
+
+    // The worker closes the catalog, so a handed-over import has to finish first
+    if (catalogImportThread.joinable()) catalogImportThread.join();
     if (workerThread.joinable()) workerThread.join();
 
     if (discordIpc) {
@@ -110,147 +204,159 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
     return 0;
 }
 
-json BuildActivityPayload(const PlayerInfo& info)
-{
-	static PlayerInfo lastInfo;
-    
-	const int& type = 2; // Default to Listening
-
-    auto now = std::chrono::system_clock::now();
-    auto nowSeconds = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
-
-    int64_t posSeconds = std::chrono::duration_cast<std::chrono::seconds>(info.position).count();
-    int64_t durSeconds = std::chrono::duration_cast<std::chrono::seconds>(info.duration).count();
-
-    json activity = {
-        {"type", type}, // Listening
-        {"details", WideToUTF8(info.title)},
-        {"state", WideToUTF8(info.artist)},
-        {"assets", json::object()},
-        {"buttons", json::array({
-            {
-                {"label", "Play on Music"},
-                {"url", info.albumUrl.has_value() && !info.albumUrl->empty()
-                    ? info.albumUrl.value()
-                    : "https://music.apple.com/"}
-            }
-        })}
-    };
-
-    // Set album text if available
-    if (!info.albumTitle.empty()) {
-        activity["assets"]["large_text"] = WideToUTF8(info.albumTitle);
-    }
-
-    // Set album cover or fallback image
-    activity["assets"]["large_image"] = (info.thumbnailUrl.has_value() && !info.thumbnailUrl->empty())
-        ? info.thumbnailUrl.value()
-        : "apple_music_logo";
-
-    // Handle playback state
-    if (info.playbackStatus == winrt::Windows::Media::Control::GlobalSystemMediaTransportControlsSessionPlaybackStatus::Paused) {
-        activity["state"] = "Paused | " + WideToUTF8(info.artist);
-        activity.erase("timestamps");
-    }
-    else if (info.playbackStatus == winrt::Windows::Media::Control::GlobalSystemMediaTransportControlsSessionPlaybackStatus::Playing) {
-        int64_t startTime = nowSeconds - posSeconds;
-        int64_t endTime = startTime + durSeconds;
-
-        activity["timestamps"] = {
-            {"start", startTime},
-            {"end", endTime}
-        };
-    }
-    else {
-        activity.erase("timestamps");
-    }
-
-    lastInfo = info;
-
-    return activity;
-}
-
+static Task<void> PublishAsync(PresenceUpdate update);
+static Task<void> RecordPlayAsync(PlayRecord play);
+static void EnqueuePresence(const PlayerInfo& info);
+static void ReportQueueStats();
 static void IPCNotifyRetry();
+static void StartPresenceClock(bool restart = true);
+static void ReportFirstPresence();
 static bool IsDiscordRunning();
 static bool IsAppleMusicRunning();
-static void ConnectToDiscord();
+static bool TryConnectToDiscord();
+static bool IsDiscordConnected();
+
+static void ReportWakeups(const SchedulerPeriod& period);
 
 // Background thread
 DWORD WINAPI Init(LPVOID) {
+    using Clock = std::chrono::steady_clock;
+    using PlaybackStatus = winrt::Windows::Media::Control::GlobalSystemMediaTransportControlsSessionPlaybackStatus;
+
     isRunning.store(true);
+    StartPresenceClock();
 
-    std::thread discordWaiter([] {
-        while (isRunning.load()) {
-            if (IsDiscordRunning()) {
-                IPCNotifyRetry();
-            }
-            std::this_thread::sleep_for(std::chrono::seconds(5));
-        }
-        });
+    ipcExecutor = std::make_unique<Executor>();
+    recordExecutor = std::make_unique<Executor>();
+    presenceSnapshotPath = GetAppDataPath(L"presence.json");
+
+    presenceTemplates = PresenceTemplates::Load(GetAppDataPath(L"presence-templates.json"));
 
     player->SetPlayerInfoHandler([&](const PlayerInfo& info) {
         if (!info.isValid()) return;
 
-        {
-            std::lock_guard<std::mutex> lock(ipcMtx);
-            if (!discordIpc || !discordIpc->IsConnected()) return;
+        // The media callback thread only copies into the queue; Discord and network latency stay on the publisher
+        EnqueuePresence(info);
+    });
+    player->SetStateChangedHandler(WakeScheduler);
 
-            if (!info.thumbnailUrl.has_value()) {
-                player->ForceUpdate(PlayerForceUpdateFlags::Thumbnail);
-            }
+        catalog->Open(GetAppDataPath(L"catalog.idx"));
+        player->SetCatalogIndex(catalog);
+
+        history->Open(GetAppDataPath(L"history"));
+        nowPlayingFeed.Open();
+
+        prefetcher = std::make_shared<ArtworkPrefetcher>(catalog, history, GetAppDataPath(L"prefetch-state.json"));
+        prefetcher->Start();
 
-            json activity = BuildActivityPayload(info);
-            if (!discordIpc->SendActivity(activity)) {
-                IPCNotifyRetry();
+        if (auto scrobblerConfig = ScrobblerConfig::Load(GetAppDataPath(L"scrobbler.json"))) {
+            scrobbler = std::make_shared<Scrobbler>(std::move(*scrobblerConfig), GetAppDataPath(L"scrobble-queue.jsonl"));
+            scrobbler->Start();
+        }
+
+        player->SetPlayFinishedHandler([](const PlayRecord& play) {
+            RecordPlayAsync(play).Detach();
+        });
+
+        // Show the previous session's presence right away; the live session replaces it once SMTC reports in,
+        // and clears it if Apple Music turns out to have no session
+        if (auto snapshot = LoadPresenceSnapshot(presenceSnapshotPath)) {
+            if (IsAppleMusicRunning()) {
+                {
+                    std::lock_guard<std::mutex> lock(ipcMtx);
+                    lastPresence = std::move(snapshot);
+                }
+                if (IsDiscordRunning()) {
+                    TryConnectToDiscord();
+                }
             }
         }
-    });
+
         player->Initialize();
-        ConnectToDiscord();
+
+        // Paused, stopped and detached states sleep until an event arrives; see AdaptiveScheduler
+        AdaptiveScheduler scheduler(Clock::now());
+        uint64_t seenVersion = 0;
 
         while (isRunning.load(std::memory_order_acquire)) {
-            std::unique_lock<std::mutex> lock(player->m_cvMutex);
-            player->m_cv.wait(lock, [&] {
-                return !isRunning.load(std::memory_order_acquire) || player->m_sessionAttached.load(std::memory_order_acquire);
-                });
+            auto now = Clock::now();
 
-            if (!isRunning.load(std::memory_order_acquire)) {
-                break;
+            bool attached = player->m_sessionAttached.load(std::memory_order_acquire);
+            if (attached && !IsAppleMusicRunning()) {
+                player->m_sessionAttached.store(false, std::memory_order_release);
+                attached = false;
             }
 
-            while ((!discordIpc || !discordIpc->IsConnected()) && isRunning.load(std::memory_order_acquire) && player->m_sessionAttached.load(std::memory_order_acquire)) {
-                    if (!discordIpc || !discordIpc->IsConnected()) ConnectToDiscord();
+            SchedulerInputs inputs;
+            inputs.attached = attached;
+            inputs.playing = attached && player->GetPlaybackStatus() == PlaybackStatus::Playing;
+            inputs.discordConnected = IsDiscordConnected();
+            inputs.needsTimelineSample = inputs.playing && player->NeedsTimelineSample();
 
-                    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-                }
+            auto actions = scheduler.Wake(inputs, now);
+            if (actions.finished) {
+                ReportWakeups(*actions.finished);
+            }
+
+            switch (scheduler.State()) {
+            case SchedulerState::NoSession: {
+                nowPlayingFeed.Clear();
+                prefetcher->SetIdle(true);
 
-            size_t i = 0;
-            while (true) {
-                if (!isRunning.load(std::memory_order_acquire) || !player->m_sessionAttached.load(std::memory_order_acquire) || !IsAppleMusicRunning()) {
-                    if (discordIpc) {
-                        discordIpc.reset();
-                    }
-                    player->m_sessionAttached.store(false, std::memory_order_release);
-                    player->m_cv.notify_one();
-                    break;
+                std::lock_guard<std::mutex> lock(ipcMtx);
+                if (discordIpc) {
+                    discordIpc.reset();
                 }
+                break;
+            }
 
-                lock.unlock();
+            case SchedulerState::Idle:
+                // Paused time is spent warming artwork for what is likely to play next
+                prefetcher->SetIdle(true, player->GetCurrentArtist());
+                break;
 
-                ConnectToDiscord();
+            case SchedulerState::Playing:
+                prefetcher->SetIdle(false);
+                break;
+            }
 
-                // FIXME: Make this only based off if duration and position is == 0
-                if (!player->isValidTrack()) {
-                    player->ForceUpdate(PlayerForceUpdateFlags::Duration | PlayerForceUpdateFlags::Position);
-                }
+            if (actions.connectDiscord && IsDiscordRunning()) {
+                TryConnectToDiscord();
+            }
+            if (actions.pollTimeline) {
+                player->Refresh<PlayerForceUpdateFlags::Duration | PlayerForceUpdateFlags::Position>();
+            }
 
-                std::this_thread::sleep_for(std::chrono::seconds(1));
+            inputs.discordConnected = IsDiscordConnected();
+            inputs.needsTimelineSample = inputs.playing && player->NeedsTimelineSample();
+            auto deadline = scheduler.NextDeadline(inputs);
 
-                lock.lock();
+            std::unique_lock<std::mutex> lock(wakeMtx);
+            auto woken = [&] { return !isRunning.load(std::memory_order_acquire) || wakeVersion != seenVersion; };
+            if (deadline) {
+                wakeCv.wait_until(lock, *deadline, woken);
+            }
+            else {
+                wakeCv.wait(lock, woken);
             }
+            seenVersion = wakeVersion;
         }
 
- 
+        ReportWakeups(scheduler.Finish(Clock::now()));
+
+    // Nothing new starts from here. Coroutines still suspended on SMTC, HTTP or the executor are waited
+    // out while everything they touch is alive, producers (the player) first.
+    player->Shutdown();
+    presenceTasks.CancelAndJoin();
+
+    ipcExecutor->Stop();
+    ipcExecutor.reset();
+    ReportQueueStats();
+
+    // Stop drains what is queued, so plays finished before the player shut down still reach the disk
+    recordExecutor->Stop();
+    recordExecutor.reset();
+
        if (player){
         player.reset();
        }
@@ -259,10 +365,16 @@ DWORD WINAPI Init(LPVOID) {
         discordIpc.reset();
     }
 
-    if (discordWaiter.joinable()) {
-        discordWaiter.join();
+    if (scrobbler) {
+        scrobbler->Stop();
     }
 
+    prefetcher->Stop();
+
+    catalog->Close();
+    history->Close();
+    nowPlayingFeed.Close();
+
 
     return 0;
 }
@@ -287,10 +399,34 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
     case WM_COMMAND:
         if (LOWORD(wParam) == IDM_EXIT) {
             isRunning.store(false);
+            WakeScheduler();
             DestroyWindow(hwnd);
         }
         break;
 
+    case WM_COPYDATA: {
+        auto* copy = reinterpret_cast<const COPYDATASTRUCT*>(lParam);
+        if (!copy || copy->dwData != COPYDATA_CATALOG_IMPORT || copy->cbData == 0 || copy->cbData % sizeof(wchar_t) != 0) {
+            return FALSE;
+        }
+
+        // One import at a time, and only once Init has the index open
+        if (catalogImportRunning.load() || !catalog->IsOpen()) {
+            return FALSE;
+        }
+
+        std::wstring csvPath(static_cast<const wchar_t*>(copy->lpData), copy->cbData / sizeof(wchar_t));
+        while (!csvPath.empty() && csvPath.back() == L'\0') csvPath.pop_back();
+
+        if (catalogImportThread.joinable()) catalogImportThread.join();
+        catalogImportRunning.store(true);
+        catalogImportThread = std::thread([csvPath = std::move(csvPath)] {
+            catalog->ImportCsv(csvPath);
+            catalogImportRunning.store(false);
+        });
+        return TRUE;
+    }
+
     case WM_DESTROY:
         Shell_NotifyIcon(NIM_DELETE, &nid);
         PostQuitMessage(0);
@@ -303,36 +439,258 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
     return 0;
 }
 
-static void ConnectToDiscord() {
-    const uint64_t clientId = 1402044057647186053;
+static int RunCatalogImport(const wchar_t* csvPath, bool leaseHeld) {
+    // Holding the lease means no instance has the index open, so it can be imported here
+    if (leaseHeld) {
+        catalog->Open(GetAppDataPath(L"catalog.idx"));
+        bool imported = catalog->ImportCsv(csvPath);
+        catalog->Close();
+        return imported ? 0 : 1;
+    }
+
+    // Otherwise the holder does it. It may still be starting up (no window yet, or Init has not opened the
+    // index) or busy with another import, so keep offering it for a few seconds.
+    for (int attempt = 0; attempt < 40; ++attempt) {
+        if (HWND holder = FindWindowW(WINDOW_CLASS_NAME, nullptr)) {
+            if (ForwardCatalogImport(holder, csvPath)) return 0;
+        }
+        Sleep(250);
+    }
 
-    while (isRunning.load()) {
-        std::unique_lock<std::mutex> lock(ipcMtx);
+    OutputDebugStringA("The running instance never took the catalog import.\n");
+    return 1;
+}
 
-        if (discordIpc && discordIpc->IsConnected())
-            break;
+static bool ForwardCatalogImport(HWND target, const wchar_t* csvPath) {
+    // The running instance has a different working directory
+    DWORD length = GetFullPathNameW(csvPath, 0, nullptr, nullptr);
+    if (length == 0) return false;
 
-        ipcCv.wait(lock, [&] { return ipcTryConnect || !isRunning.load(); });
+    std::wstring fullPath(length, L'\0');
+    length = GetFullPathNameW(csvPath, length, fullPath.data(), nullptr);
+    fullPath.resize(length);
 
-        if (!isRunning.load()) break;
-        ipcTryConnect = false;
+    COPYDATASTRUCT copy{};
+    copy.dwData = COPYDATA_CATALOG_IMPORT;
+    copy.cbData = static_cast<DWORD>((fullPath.size() + 1) * sizeof(wchar_t));
+    copy.lpData = fullPath.data();
 
-        discordIpc = std::make_shared<DiscordIPC>(std::to_string(clientId));
-        if (discordIpc->Connect()) {
-            OutputDebugStringA("Discord IPC connected.\n");
-            break;
-        }
-        OutputDebugStringA("Discord IPC not available. Retrying...\n");
+    DWORD_PTR accepted = FALSE;
+    if (!SendMessageTimeoutW(target, WM_COPYDATA, 0, reinterpret_cast<LPARAM>(&copy), SMTO_ABORTIFHUNG, 5000, &accepted) || !accepted) {
+        OutputDebugStringA("Running instance did not accept the catalog import.\n");
+        return false;
+    }
+
+    OutputDebugStringA("Catalog import handed to the running instance.\n");
+    return true;
+}
+
+static bool TryConnectToDiscord() {
+    const uint64_t clientId = 1402044057647186053;
+
+    std::unique_lock<std::mutex> lock(ipcMtx);
+
+    if (discordIpc && discordIpc->IsConnected())
+        return true;
+
+    discordIpc = std::make_shared<DiscordIPC>(std::to_string(clientId));
+    if (!discordIpc->Connect()) {
+        OutputDebugStringA("Discord IPC not available.\n");
         discordIpc.reset();
+        return false;
+    }
+
+    OutputDebugStringA("Discord IPC connected.\n");
+    StartPresenceClock(false);
+    std::optional<PlayerInfo> previous = lastPresence;
+    lock.unlock();
+
+    // Replay the last presence immediately, then publish whatever is playing now
+    if (previous) {
+        EnqueuePresence(*previous);
+    }
+    if (player && player->isValidTrack()) {
+        player->Refresh<PlayerForceUpdateFlags::None>();
     }
+    return true;
 }
 
-static void IPCNotifyRetry() {
+static bool IsDiscordConnected() {
+    std::lock_guard<std::mutex> lock(ipcMtx);
+    return discordIpc && discordIpc->IsConnected();
+}
+
+static void WakeScheduler() {
     {
-        std::lock_guard<std::mutex> lock(ipcMtx);
-        ipcTryConnect = true;
+        std::lock_guard<std::mutex> lock(wakeMtx);
+        ++wakeVersion;
+    }
+    wakeCv.notify_one();
+}
+
+static void ReportWakeups(const SchedulerPeriod& period) {
+    static const char* names[] = { "no session", "idle", "playing" };
+
+    auto seconds = std::chrono::duration<double>(period.elapsed).count();
+    if (seconds <= 0.0) return;
+
+    std::ostringstream out;
+    out << "Scheduler: " << period.wakeups << " wakeups in " << names[static_cast<int>(period.state)] << " state over "
+        << std::fixed << std::setprecision(1) << seconds << " s (" << (period.wakeups * 60.0 / seconds) << "/min)\n";
+    OutputDebugStringA(out.str().c_str());
+}
+
+static void IPCNotifyRetry() {
+    // The Init loop notices the dropped connection and reconnects
+    WakeScheduler();
+}
+
+static Task<void> DrainPresenceAsync() {
+    auto scope = presenceTasks.Enter();
+    if (!scope) co_return;
+
+    co_await ipcExecutor->Schedule();
+
+    // Cleared before draining, so a push that lands mid-drain schedules another pass
+    drainScheduled.store(false, std::memory_order_release);
+
+    // Anything older than the newest entry is superseded. Concurrent producers can push slightly out of
+    // sequence order, so keep the highest sequence rather than the last entry popped.
+    PresenceUpdate latest;
+    PresenceUpdate popped;
+    bool any = false;
+    while (presenceQueue.TryPop(popped)) {
+        if (!any || popped.sequence > latest.sequence) {
+            latest = std::move(popped);
+        }
+        any = true;
+    }
+
+    static uint64_t drains = 0;
+    if (any && ++drains % 256 == 0) {
+        ReportQueueStats();
+    }
+
+    if (any) {
+        // Overlays see the update whether or not Discord is connected; PublishAsync fills in the artwork
+        nowPlayingFeed.Publish(latest.info, latest.sequence);
+        co_await PublishAsync(std::move(latest));
+    }
+}
+
+static void EnqueuePresence(const PlayerInfo& info) {
+    presenceQueue.Push({ presenceSequence.fetch_add(1, std::memory_order_relaxed) + 1, info });
+
+    // One executor post per burst rather than one per update
+    if (!drainScheduled.exchange(true, std::memory_order_acq_rel)) {
+        DrainPresenceAsync().Detach();
+    }
+}
+
+static void ReportQueueStats() {
+    auto stats = presenceQueue.Stats();
+    if (stats.popped == 0) return;
+
+    auto averageUs = std::chrono::duration_cast<std::chrono::microseconds>(stats.totalDwell).count() / static_cast<int64_t>(stats.popped);
+    auto maxUs = std::chrono::duration_cast<std::chrono::microseconds>(stats.maxDwell).count();
+
+    std::ostringstream out;
+    out << "Presence queue: " << stats.pushed << " pushed, " << stats.popped << " popped, " << stats.overwritten
+        << " overwritten, max depth " << stats.maxDepth << ", dwell avg " << averageUs << " us / max " << maxUs << " us\n";
+    OutputDebugStringA(out.str().c_str());
+}
+
+// Only awaited from DrainPresenceAsync, whose scope covers it
+static Task<void> PublishAsync(PresenceUpdate update) {
+    // All Discord I/O happens on the IPC executor
+    co_await ipcExecutor->Schedule();
+
+    PlayerInfo& info = update.info;
+
+    if (!info.thumbnailUrl.has_value()) {
+        // Resolved even without Discord, since overlays read the artwork from the feed. Suspends on SMTC and
+        // the network instead of blocking the IPC thread.
+        PlayerInfo resolved;
+        if (co_await player->RefreshAsync<PlayerForceUpdateFlags::Thumbnail>(resolved, false) && resolved.isValid()) {
+            info = std::move(resolved);
+        }
+        co_await ipcExecutor->Schedule();
+        if (presenceTasks.IsCancelled()) co_return;
+
+        // The drain published this update without artwork; the feed ignores it if a newer one went out meanwhile
+        if (info.thumbnailUrl.has_value()) {
+            nowPlayingFeed.Publish(info, update.sequence);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(ipcMtx);
+    if (!discordIpc || !discordIpc->IsConnected()) co_return;
+
+    // While this update was suspended on the lookup above, a later drain may already have sent a newer one
+    if (update.sequence <= lastSentSequence) {
+        OutputDebugStringA("Dropping superseded presence update.\n");
+        co_return;
     }
-    ipcCv.notify_one();  // Wake the thread
+
+    // Per-update scratch memory, released wholesale before each publish
+    static UpdateArena arena;
+    static size_t publishCount = 0;
+    arena.Reset();
+
+    AllocationAudit audit;
+
+    std::pmr::string activity(arena.Resource());
+    BuildActivityPayload(info, presenceTemplates, activity);
+    bool sent = discordIpc->SendActivity(activity);
+
+    // Once warmed up, building and sending an update must not touch the global heap. Only counting builds
+    // can see this (release reports zero); the payload half is enforced by tests/activity-payload-tests.cpp.
+    if (sent && ++publishCount > 2 && audit.Allocations() != 0) {
+        OutputDebugStringA(("Allocation audit: " + std::to_string(audit.Allocations()) + " heap allocations in steady-state update\n").c_str());
+        assert(!"Steady-state presence update allocated from the global heap");
+    }
+
+    if (!sent) {
+        IPCNotifyRetry();
+        co_return;
+    }
+
+    lastSentSequence = update.sequence;
+    ReportFirstPresence();
+
+    // Only changes reach the disk; progress ticks keep the same start anchor
+    if (lastPresence && !PresenceDiffers(*lastPresence, info)) co_return;
+    lastPresence = info;
+    lock.unlock();
+
+    if (!SavePresenceSnapshot(presenceSnapshotPath, info)) {
+        OutputDebugStringA("Failed to save presence snapshot.\n");
+    }
+}
+
+static Task<void> RecordPlayAsync(PlayRecord play) {
+    co_await recordExecutor->Schedule();
+
+    history->Append(play);
+    if (scrobbler) {
+        scrobbler->Submit(play);
+    }
+}
+
+static void StartPresenceClock(bool restart) {
+    std::lock_guard<std::mutex> lock(presenceMetricMtx);
+    if (!restart && presencePending) return; // Keep measuring from startup
+    presenceClockStart = std::chrono::steady_clock::now();
+    presencePending = true;
+}
+
+static void ReportFirstPresence() {
+    std::lock_guard<std::mutex> lock(presenceMetricMtx);
+    if (!presencePending) return;
+    presencePending = false;
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - presenceClockStart);
+    OutputDebugStringA(("Time to first presence: " + std::to_string(elapsed.count()) + " ms\n").c_str());
 }
 
 static bool IsDiscordRunning() {
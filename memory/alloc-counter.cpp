@@ -0,0 +1,74 @@
+#include "alloc-counter.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef AMRP_ALLOCATION_COUNTING
+
+static thread_local size_t threadAllocations = 0;
+
+size_t ThreadAllocationCount() {
+    return threadAllocations;
+}
+
+void* operator new(size_t size) {
+    ++threadAllocations;
+    if (size == 0) size = 1;
+
+    while (true) {
+        if (void* ptr = std::malloc(size)) return ptr;
+
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new[](size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return ::operator new(size);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+#else
+
+size_t ThreadAllocationCount() {
+    return 0;
+}
+
+#endif
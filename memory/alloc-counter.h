@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+// Debug builds, and any build defining AMRP_COUNT_ALLOCATIONS (the test project does), replace the
+// global operator new to count heap allocations per thread. Other builds always report zero.
+#if defined(_DEBUG) || defined(AMRP_COUNT_ALLOCATIONS)
+#define AMRP_ALLOCATION_COUNTING 1
+#endif
+
+size_t ThreadAllocationCount();
+
+// Counts the heap allocations made on the current thread while in scope
+class AllocationAudit {
+public:
+    AllocationAudit() : m_start(ThreadAllocationCount()) {}
+
+    size_t Allocations() const {
+        return ThreadAllocationCount() - m_start;
+    }
+
+private:
+    size_t m_start;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+// Monotonic scratch memory for one presence update. Everything allocated from
+// Resource() is released at once by Reset(), so a steady-state update never
+// touches the global heap unless it outgrows the initial buffer.
+class UpdateArena {
+public:
+    explicit UpdateArena(size_t capacity = 16 * 1024)
+        : m_buffer(capacity),
+        m_resource(m_buffer.data(), m_buffer.size(), std::pmr::new_delete_resource()) {
+    }
+
+    UpdateArena(const UpdateArena&) = delete;
+    UpdateArena& operator=(const UpdateArena&) = delete;
+
+    std::pmr::memory_resource* Resource() {
+        return &m_resource;
+    }
+
+    void Reset() {
+        m_resource.release();
+    }
+
+private:
+    std::vector<std::byte> m_buffer;
+    std::pmr::monotonic_buffer_resource m_resource;
+};
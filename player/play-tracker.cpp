@@ -0,0 +1,77 @@
+#include "play-tracker.h"
+
+void PlayTracker::Accumulate(Clock::time_point now) {
+    if (m_playing) {
+        m_played += now - m_lastObserved;
+    }
+    m_lastObserved = now;
+}
+
+bool PlayTracker::IsRestart(const PlayerInfo& info, Clock::time_point now) const {
+    auto duration = info.duration.count() > 0 ? info.duration : m_current->duration;
+    if (duration <= 2 * RestartWindow) return false; // Too short to tell a restart from a seek
+
+    // Observations are sparse, so extrapolate where the previous one had got to by now
+    auto reached = m_lastPosition;
+    if (m_playing) {
+        reached += std::chrono::duration_cast<std::chrono::seconds>(now - m_lastObserved);
+    }
+
+    return reached >= duration - RestartWindow && info.position <= RestartWindow;
+}
+
+std::optional<PlayRecord> PlayTracker::Observe(const PlayerInfo& info, Clock::time_point now) {
+    bool playing = info.playbackStatus == GlobalSystemMediaTransportControlsSessionPlaybackStatus::Playing;
+
+    bool sameTrack = m_current &&
+        m_current->title == info.title &&
+        m_current->artist == info.artist &&
+        m_current->albumTitle == info.albumTitle;
+
+    // Repeat-one never changes the track, so a wrap back to the start has to end the play as well
+    if (sameTrack && !IsRestart(info, now)) {
+        Accumulate(now);
+        m_playing = playing;
+        m_lastPosition = info.position;
+        if (info.duration.count() > 0) {
+            m_current->duration = info.duration;
+        }
+        return std::nullopt;
+    }
+
+    std::optional<PlayRecord> finished = Finish(now);
+
+    if (!info.title.empty() && !info.artist.empty()) {
+        PlayRecord play;
+        play.title = info.title;
+        play.artist = info.artist;
+        play.albumTitle = info.albumTitle;
+        play.startedAt = std::chrono::system_clock::now();
+        play.duration = info.duration;
+
+        m_current = std::move(play);
+        m_played = {};
+        m_lastObserved = now;
+        m_lastPosition = info.position;
+        m_playing = playing;
+    }
+
+    return finished;
+}
+
+std::optional<PlayRecord> PlayTracker::Finish(Clock::time_point now) {
+    if (!m_current) return std::nullopt;
+
+    Accumulate(now);
+
+    PlayRecord play = std::move(*m_current);
+    play.played = std::chrono::duration_cast<std::chrono::seconds>(m_played);
+
+    m_current.reset();
+    m_played = {};
+    m_lastPosition = {};
+    m_playing = false;
+
+    if (play.played < MinimumPlay) return std::nullopt;
+    return play;
+}
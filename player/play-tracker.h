@@ -0,0 +1,50 @@
+#pragma once
+
+#include "player-types.h"
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+// One finished listen of a track
+struct PlayRecord {
+    std::wstring title;
+    std::wstring artist;
+    std::wstring albumTitle;
+
+    std::chrono::system_clock::time_point startedAt{};
+    std::chrono::seconds played{};
+    std::chrono::seconds duration{};
+};
+
+using PlayFinishedHandler = std::function<void(const PlayRecord& play)>;
+
+// Turns the stream of PlayerInfo snapshots into finished plays by accumulating
+// time spent in the Playing state until the track changes, restarts (repeat-one
+// or a replay) or the session ends.
+class PlayTracker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Listens shorter than this are treated as skips and not reported
+    static constexpr std::chrono::seconds MinimumPlay{ 10 };
+
+    // A jump from within this much of the end back to within this much of the start is a new play
+    static constexpr std::chrono::seconds RestartWindow{ 10 };
+
+    std::optional<PlayRecord> Observe(const PlayerInfo& info) { return Observe(info, Clock::now()); }
+    std::optional<PlayRecord> Finish() { return Finish(Clock::now()); }
+
+    std::optional<PlayRecord> Observe(const PlayerInfo& info, Clock::time_point now);
+    std::optional<PlayRecord> Finish(Clock::time_point now);
+
+private:
+    std::optional<PlayRecord> m_current;
+    Clock::duration m_played{};
+    Clock::time_point m_lastObserved{};
+    std::chrono::seconds m_lastPosition{};
+    bool m_playing = false;
+
+    void Accumulate(Clock::time_point now);
+    bool IsRestart(const PlayerInfo& info, Clock::time_point now) const;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+
+// Keeps the last authoritative timeline sample from SMTC and extrapolates the
+// playback position locally with a monotonic clock, so the source only has to
+// be queried again on status changes or when a seek is detected.
+class PlayerTimeline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Reported positions further than this from the extrapolated one are treated as a seek
+    static constexpr std::chrono::milliseconds DriftThreshold{ 2000 };
+
+    void Sync(std::chrono::milliseconds position, std::chrono::milliseconds duration, bool playing) {
+        m_position = position;
+        m_duration = duration;
+        m_playing = playing;
+        m_sampledAt = Clock::now();
+        m_startTime = std::chrono::time_point_cast<std::chrono::seconds>(std::chrono::system_clock::now() - position);
+        m_hasSample = true;
+    }
+
+    void Reset() {
+        *this = PlayerTimeline{};
+    }
+
+    bool HasSample() const {
+        return m_hasSample;
+    }
+
+    bool IsPlaying() const {
+        return m_playing;
+    }
+
+    std::chrono::milliseconds Duration() const {
+        return m_duration;
+    }
+
+    std::chrono::milliseconds Position() const {
+        if (!m_hasSample || !m_playing)
+            return m_position;
+
+        auto position = m_position + std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - m_sampledAt);
+        if (m_duration.count() > 0 && position > m_duration)
+            return m_duration;
+        return position;
+    }
+
+    // Wall-clock time the track started, fixed at the last sync so Discord timestamps stay stable
+    std::chrono::system_clock::time_point StartTime() const {
+        return m_startTime;
+    }
+
+    bool IsDrifted(std::chrono::milliseconds reportedPosition) const {
+        if (!m_hasSample)
+            return true;
+
+        auto drift = reportedPosition - Position();
+        if (drift.count() < 0) drift = -drift;
+        return drift > DriftThreshold;
+    }
+
+private:
+    Clock::time_point m_sampledAt{};
+    std::chrono::system_clock::time_point m_startTime{};
+    std::chrono::milliseconds m_position{};
+    std::chrono::milliseconds m_duration{};
+    bool m_playing = false;
+    bool m_hasSample = false;
+};
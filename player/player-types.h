@@ -8,6 +8,10 @@
 
 #include <functional>
 
+#include "../async/task.h"
+
+class CatalogIndex;
+
 enum PlayerForceUpdateFlags : uint32_t {
     None = 0,
     Title = 1 << 0,
@@ -19,13 +23,13 @@ enum PlayerForceUpdateFlags : uint32_t {
     Status = 1 << 6
 };
 
-inline PlayerForceUpdateFlags operator|(PlayerForceUpdateFlags a, PlayerForceUpdateFlags b) {
+constexpr PlayerForceUpdateFlags operator|(PlayerForceUpdateFlags a, PlayerForceUpdateFlags b) {
     return static_cast<PlayerForceUpdateFlags>(
         static_cast<uint32_t>(a) | static_cast<uint32_t>(b)
         );
 }
 
-inline PlayerForceUpdateFlags operator&(PlayerForceUpdateFlags a, PlayerForceUpdateFlags b) {
+constexpr PlayerForceUpdateFlags operator&(PlayerForceUpdateFlags a, PlayerForceUpdateFlags b) {
     return static_cast<PlayerForceUpdateFlags>(
         static_cast<uint32_t>(a) & static_cast<uint32_t>(b)
         );
@@ -36,7 +40,7 @@ inline PlayerForceUpdateFlags& operator|=(PlayerForceUpdateFlags& a, PlayerForce
     return a;
 }
 
-inline bool Any(PlayerForceUpdateFlags flags, PlayerForceUpdateFlags test) {
+constexpr bool Any(PlayerForceUpdateFlags flags, PlayerForceUpdateFlags test) {
     return static_cast<uint32_t>(flags & test) != 0;
 }
 
@@ -53,6 +57,9 @@ struct PlayerInfo
     std::chrono::seconds duration{};
     std::chrono::seconds position{};
 
+    // Wall-clock start of the track, anchored at the last timeline sync
+    std::chrono::system_clock::time_point startTime{};
+
     winrt::Windows::Media::Control::GlobalSystemMediaTransportControlsSessionPlaybackStatus playbackStatus;
 
     std::optional<std::string> thumbnailUrl;
@@ -93,7 +100,8 @@ struct PlayerInfo
         }
 	}
 
-    void UpdateUrls();
+    // Resolves artwork and album URLs, from the catalog index when possible
+    Task<void> UpdateUrlsAsync(CatalogIndex* catalog = nullptr);
 };
 
 using PlayerInfoHandler = std::function<void(const PlayerInfo& info)>;
\ No newline at end of file
@@ -1,4 +1,7 @@
 #include "player.h"
+#include "../catalog/catalog-index.h"
+#include "../http/http-client.h"
+#include "../strings/string-utils.h"
 
 #include <nlohmann/json.hpp>
 
@@ -8,82 +11,178 @@
 #include <filesystem>
 #include <fstream>
 #include <sstream>
-#include <winhttp.h>
 
-#pragma comment(lib, "winhttp.lib")
-
-static std::string WideToUTF8(const std::wstring& wide) {
-    if (wide.empty()) return {};
-
-    int utf8Size = WideCharToMultiByte(CP_UTF8, 0, wide.c_str(), -1, nullptr, 0, nullptr, nullptr);
-    if (utf8Size <= 0) return {};
-
-    std::string utf8(utf8Size - 1, '\0');
-    WideCharToMultiByte(CP_UTF8, 0, wide.c_str(), -1, &utf8[0], utf8Size, nullptr, nullptr);
+// Reads a timeline sample and advances its position to "now" using the sample's own timestamp
+static void ReadTimeline(const winrt::Windows::Media::Control::GlobalSystemMediaTransportControlsSessionTimelineProperties& timelineProps, bool playing,
+    std::chrono::milliseconds& position, std::chrono::milliseconds& duration)
+{
+    position = std::chrono::duration_cast<std::chrono::milliseconds>(timelineProps.Position());
+    duration = std::chrono::duration_cast<std::chrono::milliseconds>(timelineProps.EndTime() - timelineProps.StartTime());
 
-    return utf8;
+    if (playing) {
+        auto age = winrt::clock::now() - timelineProps.LastUpdatedTime();
+        if (age.count() > 0) {
+            position += std::chrono::duration_cast<std::chrono::milliseconds>(age);
+        }
+    }
 }
 
-void Player::SCMTC_ProcessSession(winrt::Windows::Media::Control::GlobalSystemMediaTransportControlsSession session)
+Task<void> Player::ProcessSessionAsync(winrt::Windows::Media::Control::GlobalSystemMediaTransportControlsSession session)
 {
+    auto scope = m_tasks.Enter();
+    if (!scope) co_return;
+
     if (!session) {
-        OutputDebugStringA("SCMTC_ProcessSession: session is null, skipping.\n");
-        return;
+        OutputDebugStringA("ProcessSessionAsync: session is null, skipping.\n");
+        co_return;
     }
 
+    // Events can start reads faster than SMTC answers them, and the answers can arrive in any order
+    uint64_t generation = m_sessionGeneration.fetch_add(1, std::memory_order_acq_rel) + 1;
+
     try {
 
         {
-            auto mediaProps = session.TryGetMediaPropertiesAsync().get();
+            auto mediaProps = co_await session.TryGetMediaPropertiesAsync();
+            if (m_tasks.IsCancelled()) co_return;
+
             auto playbackInfo = session.GetPlaybackInfo();
             auto timelineProps = session.GetTimelineProperties();
 
-            auto position = std::chrono::duration_cast<std::chrono::seconds>(timelineProps.Position());
-            auto duration = std::chrono::duration_cast<std::chrono::seconds>(timelineProps.EndTime() - timelineProps.StartTime());
+            // Status or track changed, so this sample becomes the new authoritative one
+            bool playing = playbackInfo.PlaybackStatus() == GlobalSystemMediaTransportControlsSessionPlaybackStatus::Playing;
+            std::chrono::milliseconds position, duration;
+            ReadTimeline(timelineProps, playing, position, duration);
 
-            PlayerInfo trackInfo(mediaProps, playbackInfo, position, duration);
+            PlayerInfo trackInfo(mediaProps, playbackInfo,
+                std::chrono::duration_cast<std::chrono::seconds>(position),
+                std::chrono::duration_cast<std::chrono::seconds>(duration));
+            trackInfo.CorrectDetails();
 
+            std::optional<PlayRecord> finishedPlay;
             {
                 std::lock_guard<std::mutex> lock(m_trackMutex);
+                if (generation != m_sessionGeneration.load(std::memory_order_acquire)) {
+                    OutputDebugStringA("ProcessSessionAsync: superseded by a newer read, dropping.\n");
+                    co_return;
+                }
+
+                m_timeline.Sync(position, duration, playing);
+                ApplyTimeline(trackInfo);
+
                 if (!m_currentTrack) {
                     m_currentTrack = std::make_shared<PlayerInfo>(trackInfo);
                 }
                 else {
                     *m_currentTrack = trackInfo;
                 }
+
+                finishedPlay = m_playTracker.Observe(trackInfo);
+            }
+
+            if (finishedPlay && m_playFinishedHandler) {
+                m_playFinishedHandler(*finishedPlay);
             }
         }
 
-        ForceUpdate(PlayerForceUpdateFlags::Thumbnail);
+        PlayerInfo trackCopy;
+        co_await RefreshAsync<PlayerForceUpdateFlags::Thumbnail>(trackCopy);
+        if (m_tasks.IsCancelled()) co_return;
 
         {
             std::lock_guard<std::mutex> lock(m_cvMutex);
             m_sessionAttached.store(true, std::memory_order_release);
             m_cv.notify_one();
         }
+
+        if (m_stateChangedHandler) {
+            m_stateChangedHandler();
+        }
     }
     catch (const winrt::hresult_error& e) {
-        OutputDebugStringA(("SCMTC_ProcessSession failed: " + std::string(winrt::to_string(e.message())) + "\n").c_str());
+        OutputDebugStringA(("ProcessSessionAsync failed: " + std::string(winrt::to_string(e.message())) + "\n").c_str());
     }
 }
 
 void Player::OnPlaybackInfoChanged(winrt::Windows::Media::Control::GlobalSystemMediaTransportControlsSession sender, winrt::Windows::Foundation::IInspectable const&)
 {
-    SCMTC_ProcessSession(sender);
+    ProcessSessionAsync(sender).Detach();
 }
 
 void Player::OnMediaPropertiesChanged(winrt::Windows::Media::Control::GlobalSystemMediaTransportControlsSession sender, winrt::Windows::Foundation::IInspectable const&)
 {
-    SCMTC_ProcessSession(sender);
+    ProcessSessionAsync(sender).Detach();
+}
+
+void Player::OnTimelinePropertiesChanged(winrt::Windows::Media::Control::GlobalSystemMediaTransportControlsSession sender, winrt::Windows::Foundation::IInspectable const&)
+{
+    auto scope = m_tasks.Enter();
+    if (!scope) return;
+
+    try {
+        auto timelineProps = sender.GetTimelineProperties();
+
+        PlayerInfo trackCopy;
+        std::optional<PlayRecord> finishedPlay;
+        {
+            std::lock_guard<std::mutex> lock(m_trackMutex);
+            if (!m_currentTrack) return;
+
+            std::chrono::milliseconds position, duration;
+            ReadTimeline(timelineProps, m_timeline.IsPlaying(), position, duration);
+
+            // Regular progress ticks are already covered by extrapolation; only seeks and new durations matter
+            if (duration == m_timeline.Duration() && !m_timeline.IsDrifted(position)) return;
+
+            m_timeline.Sync(position, duration, m_timeline.IsPlaying());
+            ApplyTimeline(*m_currentTrack);
+            trackCopy = *m_currentTrack;
+
+            // Repeat-one only shows up here, as a jump back to the start with nothing else changing
+            finishedPlay = m_playTracker.Observe(trackCopy);
+        }
+
+        if (finishedPlay && m_playFinishedHandler) {
+            m_playFinishedHandler(*finishedPlay);
+        }
+
+        if (m_playerHandler && trackCopy.isValid()) {
+            m_playerHandler(trackCopy);
+        }
+    }
+    catch (const winrt::hresult_error& e) {
+        OutputDebugStringA(("OnTimelinePropertiesChanged failed: " + std::string(winrt::to_string(e.message())) + "\n").c_str());
+    }
+}
+
+void Player::ApplyTimeline(PlayerInfo& track) const {
+    if (!m_timeline.HasSample()) return;
+
+    track.position = std::chrono::duration_cast<std::chrono::seconds>(m_timeline.Position());
+    track.duration = std::chrono::duration_cast<std::chrono::seconds>(m_timeline.Duration());
+    track.startTime = m_timeline.StartTime();
 }
 
 bool Player::CheckForAppleMusicSession() {
     for (auto const& session : m_smtcManager.GetSessions()) {
         auto appId = session.SourceAppUserModelId();
         if (std::wstring(appId.c_str()).find(L"AppleInc.AppleMusic") != std::wstring::npos) {
-            session.PlaybackInfoChanged({ this, &Player::OnPlaybackInfoChanged });
-            session.MediaPropertiesChanged({ this, &Player::OnMediaPropertiesChanged });
-            SCMTC_ProcessSession(session);
+            {
+                std::lock_guard<std::mutex> lock(m_sessionMutex);
+                if (m_tasks.IsCancelled()) return false;
+
+                m_playbackInfoRevoker = session.PlaybackInfoChanged(winrt::auto_revoke, { this, &Player::OnPlaybackInfoChanged });
+                m_mediaPropertiesRevoker = session.MediaPropertiesChanged(winrt::auto_revoke, { this, &Player::OnMediaPropertiesChanged });
+                m_timelinePropertiesRevoker = session.TimelinePropertiesChanged(winrt::auto_revoke, { this, &Player::OnTimelinePropertiesChanged });
+            }
+
+            // Attached as soon as the session exists, so a presence shown before the first read isn't torn down
+            {
+                std::lock_guard<std::mutex> lock(m_cvMutex);
+                m_sessionAttached.store(true, std::memory_order_release);
+            }
+
+            ProcessSessionAsync(session).Detach();
             return true;
         }
     }
@@ -92,9 +191,23 @@ bool Player::CheckForAppleMusicSession() {
 
 bool Player::HandleSessionsChanged() {
     if (!CheckForAppleMusicSession()) {
+        {
+            std::lock_guard<std::mutex> lock(m_sessionMutex);
+            m_playbackInfoRevoker.revoke();
+            m_mediaPropertiesRevoker.revoke();
+            m_timelinePropertiesRevoker.revoke();
+        }
+
+        std::optional<PlayRecord> finishedPlay;
         {
             std::lock_guard<std::mutex> lock(m_trackMutex);
             m_currentTrack.reset();
+            m_timeline.Reset();
+            finishedPlay = m_playTracker.Finish();
+        }
+
+        if (finishedPlay && m_playFinishedHandler) {
+            m_playFinishedHandler(*finishedPlay);
         }
 
         {
@@ -102,6 +215,10 @@ bool Player::HandleSessionsChanged() {
             m_sessionAttached.store(false, std::memory_order_release);
             m_cv.notify_one();
         }
+
+        if (m_stateChangedHandler) {
+            m_stateChangedHandler();
+        }
         return false;
     }
 
@@ -109,187 +226,250 @@ bool Player::HandleSessionsChanged() {
 }
 
 void Player::Initialize() {
-    m_smtcManager = GlobalSystemMediaTransportControlsSessionManager::RequestAsync().get();
+    SyncWait(InitializeAsync());
+}
+
+Task<void> Player::InitializeAsync() {
+    m_smtcManager = co_await GlobalSystemMediaTransportControlsSessionManager::RequestAsync();
+
+    m_sessionsChangedRevoker = m_smtcManager.SessionsChanged(winrt::auto_revoke, [this](auto&&...) {
+        auto scope = m_tasks.Enter();
+        if (!scope) return;
 
-    m_smtcManager.SessionsChanged([this](auto&&...) {
         HandleSessionsChanged();
     });
 
     HandleSessionsChanged();
 }
 
+void Player::Shutdown() {
+    // Callbacks that arrive from here on return immediately; the ones already running finish first
+    m_tasks.CancelAndJoin();
+
+    std::lock_guard<std::mutex> lock(m_sessionMutex);
+    m_sessionsChangedRevoker.revoke();
+    m_playbackInfoRevoker.revoke();
+    m_mediaPropertiesRevoker.revoke();
+    m_timelinePropertiesRevoker.revoke();
+}
+
 void Player::SetPlayerInfoHandler(PlayerInfoHandler handler) {
     m_playerHandler = std::move(handler);
 }
 
+void Player::SetPlayFinishedHandler(PlayFinishedHandler handler) {
+    m_playFinishedHandler = std::move(handler);
+}
+
+void Player::SetStateChangedHandler(std::function<void()> handler) {
+    m_stateChangedHandler = std::move(handler);
+}
+
+void Player::SetCatalogIndex(std::shared_ptr<CatalogIndex> catalog) {
+    m_catalog = std::move(catalog);
+}
+
 bool Player::isValidTrack() {
     std::lock_guard<std::mutex> lock(m_trackMutex);
     return m_currentTrack && m_currentTrack->isValid();
 }
 
+bool Player::NeedsTimelineSample() {
+    std::lock_guard<std::mutex> lock(m_trackMutex);
+    return m_currentTrack && m_currentTrack->duration.count() == 0;
+}
+
+std::optional<GlobalSystemMediaTransportControlsSessionPlaybackStatus> Player::GetPlaybackStatus() {
+    std::lock_guard<std::mutex> lock(m_trackMutex);
+    if (!m_currentTrack) return std::nullopt;
+    return m_currentTrack->playbackStatus;
+}
+
+std::wstring Player::GetCurrentArtist() {
+    std::lock_guard<std::mutex> lock(m_trackMutex);
+    return m_currentTrack ? m_currentTrack->artist : std::wstring{};
+}
+
 PlayerInfo Player::ForceUpdate(PlayerForceUpdateFlags flags, bool callHandler)
 {
+    PlayerInfo trackCopy;
+    if (!SyncWait(ForceUpdateAsync(flags, trackCopy, callHandler))) {
+        return {};
+    }
+
+    return trackCopy;
+}
+
+template <PlayerForceUpdateFlags Flags>
+PlayerInfo Player::Refresh(bool callHandler)
+{
+    PlayerInfo trackCopy;
+    if (!SyncWait(RefreshAsync<Flags>(trackCopy, callHandler))) {
+        return {};
+    }
+
+    return trackCopy;
+}
+
+Task<bool> Player::ForceUpdateAsync(PlayerForceUpdateFlags flags, PlayerInfo& out, bool callHandler)
+{
+    return UpdateAsync<DynamicFlags>(flags, out, callHandler);
+}
+
+// Folds to a constant for compile-time flags, so the untaken branches are dropped from that instantiation
+template <uint32_t StaticFlags>
+static constexpr bool Wants(PlayerForceUpdateFlags flags, PlayerForceUpdateFlags test) {
+    if constexpr (StaticFlags == Player::DynamicFlags) {
+        return Any(flags, test);
+    }
+    else {
+        return (StaticFlags & static_cast<uint32_t>(test)) != 0;
+    }
+}
+
+template <uint32_t StaticFlags>
+Task<bool> Player::UpdateAsync(PlayerForceUpdateFlags flags, PlayerInfo& out, bool callHandler)
+{
+    constexpr auto Details = PlayerForceUpdateFlags::Title | PlayerForceUpdateFlags::Artist | PlayerForceUpdateFlags::Album;
+    constexpr auto Timeline = PlayerForceUpdateFlags::Position | PlayerForceUpdateFlags::Duration;
+
     if (!m_smtcManager) {
         OutputDebugStringA("ForceUpdate: SMTC manager not available.\n");
-        return {};
+        co_return false;
     }
 
     auto session = m_smtcManager.GetCurrentSession();
     if (!session) {
         OutputDebugStringA("ForceUpdate: No current session.\n");
-        return {};
+        co_return false;
     }
 
+    // Only the text fields come from SMTC; artwork is looked up from the artist and album already held
     std::optional<winrt::Windows::Media::Control::GlobalSystemMediaTransportControlsSessionMediaProperties> mediaPropsOpt;
-    if (Any(flags, PlayerForceUpdateFlags::Title | PlayerForceUpdateFlags::Artist | PlayerForceUpdateFlags::Album | PlayerForceUpdateFlags::Thumbnail)) {
+    if (Wants<StaticFlags>(flags, Details)) {
         try {
-            mediaPropsOpt = session.TryGetMediaPropertiesAsync().get();
+            mediaPropsOpt = co_await session.TryGetMediaPropertiesAsync();
         }
         catch (const winrt::hresult_error& e) {
             OutputDebugStringA(("ForceUpdate: Failed to get media props: " + std::string(winrt::to_string(e.message())) + "\n").c_str());
         }
     }
 
-    auto timelineProps = session.GetTimelineProperties();
+    // Position is extrapolated locally; the source is only asked when there is nothing to extrapolate from
+    bool needsTimeline = false;
+    if (Wants<StaticFlags>(flags, Timeline)) {
+        std::lock_guard<std::mutex> lock(m_trackMutex);
+        needsTimeline = !m_timeline.HasSample() || m_timeline.Duration().count() == 0;
+    }
 
-    PlayerInfo trackCopy;
+    std::optional<winrt::Windows::Media::Control::GlobalSystemMediaTransportControlsSessionTimelineProperties> timelinePropsOpt;
+    if (needsTimeline) {
+        timelinePropsOpt = session.GetTimelineProperties();
+    }
+
+    PlayerInfo lookup;
+    bool resolveUrls = false;
     {
         std::lock_guard<std::mutex> lock(m_trackMutex);
         if (!m_currentTrack) {
             OutputDebugStringA("ForceUpdate: No current track.\n");
-            return {};
+            co_return false;
         }
 
         if (mediaPropsOpt) {
             const auto& mediaProps = *mediaPropsOpt;
-            if (Any(flags, PlayerForceUpdateFlags::Title)) {
+            if (Wants<StaticFlags>(flags, PlayerForceUpdateFlags::Title)) {
                 m_currentTrack->title = mediaProps.Title();
             }
-            if (Any(flags, PlayerForceUpdateFlags::Artist)) {
+            if (Wants<StaticFlags>(flags, PlayerForceUpdateFlags::Artist)) {
                 m_currentTrack->artist = mediaProps.Artist();
             }
-            if (Any(flags, PlayerForceUpdateFlags::Album)) {
+            if (Wants<StaticFlags>(flags, PlayerForceUpdateFlags::Album)) {
                 m_currentTrack->albumTitle = mediaProps.AlbumTitle();
             }
-            m_currentTrack->CorrectDetails();
-
-            if (Any(flags, PlayerForceUpdateFlags::Thumbnail)) {
-                m_currentTrack->UpdateUrls();
+            if (Wants<StaticFlags>(flags, Details)) {
+                m_currentTrack->CorrectDetails();
             }
         }
 
-        if (Any(flags, PlayerForceUpdateFlags::Position)) {
-            m_currentTrack->position = std::chrono::duration_cast<std::chrono::seconds>(timelineProps.Position());
+        if (Wants<StaticFlags>(flags, PlayerForceUpdateFlags::Thumbnail)) {
+            resolveUrls = true;
+            lookup.artist = m_currentTrack->artist;
+            lookup.albumTitle = m_currentTrack->albumTitle;
         }
-        if (Any(flags, PlayerForceUpdateFlags::Duration)) {
-            m_currentTrack->duration = std::chrono::duration_cast<std::chrono::seconds>(timelineProps.EndTime() - timelineProps.StartTime());
+
+        if (timelinePropsOpt) {
+            bool playing = m_currentTrack->playbackStatus == GlobalSystemMediaTransportControlsSessionPlaybackStatus::Playing;
+            std::chrono::milliseconds position, duration;
+            ReadTimeline(*timelinePropsOpt, playing, position, duration);
+            m_timeline.Sync(position, duration, playing);
         }
 
-        trackCopy = *m_currentTrack;
+        if (m_timeline.HasSample()) {
+            if (Wants<StaticFlags>(flags, PlayerForceUpdateFlags::Position)) {
+                m_currentTrack->position = std::chrono::duration_cast<std::chrono::seconds>(m_timeline.Position());
+            }
+            if (Wants<StaticFlags>(flags, PlayerForceUpdateFlags::Duration)) {
+                m_currentTrack->duration = std::chrono::duration_cast<std::chrono::seconds>(m_timeline.Duration());
+            }
+            m_currentTrack->startTime = m_timeline.StartTime();
+        }
     }
 
-    if (m_playerHandler && callHandler && trackCopy.isValid()) {
-        m_playerHandler(trackCopy);
+    // The lookup is suspended on the network without holding the track lock
+    if (resolveUrls) {
+        co_await lookup.UpdateUrlsAsync(m_catalog.get());
     }
 
-    return trackCopy;
-}
-
-Player::~Player() {
-    
-}
-
-std::string HttpGet(const std::wstring& url) {
-    std::string result;
-
-    URL_COMPONENTS urlComp{};
-    urlComp.dwStructSize = sizeof(urlComp);
-
-    wchar_t hostName[256];
-    wchar_t urlPath[1024];
-    urlComp.lpszHostName = hostName;
-    urlComp.dwHostNameLength = _countof(hostName);
-    urlComp.lpszUrlPath = urlPath;
-    urlComp.dwUrlPathLength = _countof(urlPath);
-
-    if (!WinHttpCrackUrl(url.c_str(), (DWORD)url.length(), 0, &urlComp)) {
-        OutputDebugStringA("Failed to crack URL\n");
-        return result;
-    }
+    {
+        std::lock_guard<std::mutex> lock(m_trackMutex);
+        if (!m_currentTrack) {
+            co_return false;
+        }
 
-    HINTERNET hSession = WinHttpOpen(L"AppleMusicClient/1.0", WINHTTP_ACCESS_TYPE_DEFAULT_PROXY, WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0);
-    if (!hSession) return result;
+        // Drop the result if the track changed while the lookup was in flight
+        if (resolveUrls && m_currentTrack->artist == lookup.artist && m_currentTrack->albumTitle == lookup.albumTitle) {
+            if (lookup.thumbnailUrl.has_value()) m_currentTrack->thumbnailUrl = lookup.thumbnailUrl;
+            if (lookup.albumUrl.has_value()) m_currentTrack->albumUrl = lookup.albumUrl;
+        }
 
-    HINTERNET hConnect = WinHttpConnect(hSession, std::wstring(hostName, urlComp.dwHostNameLength).c_str(), urlComp.nPort, 0);
-    if (!hConnect) {
-        WinHttpCloseHandle(hSession);
-        return result;
+        out = *m_currentTrack;
     }
 
-    HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"GET", std::wstring(urlPath, urlComp.dwUrlPathLength).c_str(), NULL,
-        WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES,
-        (urlComp.nScheme == INTERNET_SCHEME_HTTPS) ? WINHTTP_FLAG_SECURE : 0);
-
-    if (!hRequest) {
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
-        return result;
+    if (m_playerHandler && callHandler && out.isValid()) {
+        m_playerHandler(out);
     }
 
-    BOOL bResults = WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS, 0,
-        WINHTTP_NO_REQUEST_DATA, 0,
-        0, 0);
-
-    if (bResults)
-        bResults = WinHttpReceiveResponse(hRequest, NULL);
+    co_return true;
+}
 
-    if (bResults) {
-        DWORD dwSize = 0;
-        do {
-            DWORD dwDownloaded = 0;
-            WinHttpQueryDataAvailable(hRequest, &dwSize);
+// Runtime flags plus the compile-time combinations used by callers
+template Task<bool> Player::UpdateAsync<Player::DynamicFlags>(PlayerForceUpdateFlags, PlayerInfo&, bool);
+template Task<bool> Player::UpdateAsync<PlayerForceUpdateFlags::None>(PlayerForceUpdateFlags, PlayerInfo&, bool);
+template Task<bool> Player::UpdateAsync<PlayerForceUpdateFlags::Thumbnail>(PlayerForceUpdateFlags, PlayerInfo&, bool);
+template Task<bool> Player::UpdateAsync<PlayerForceUpdateFlags::Duration | PlayerForceUpdateFlags::Position>(PlayerForceUpdateFlags, PlayerInfo&, bool);
+template Task<bool> Player::UpdateAsync<PlayerForceUpdateFlags::Position>(PlayerForceUpdateFlags, PlayerInfo&, bool);
 
-            if (dwSize == 0)
-                break;
+template PlayerInfo Player::Refresh<PlayerForceUpdateFlags::None>(bool);
+template PlayerInfo Player::Refresh<PlayerForceUpdateFlags::Thumbnail>(bool);
+template PlayerInfo Player::Refresh<PlayerForceUpdateFlags::Duration | PlayerForceUpdateFlags::Position>(bool);
+template PlayerInfo Player::Refresh<PlayerForceUpdateFlags::Position>(bool);
 
-            std::vector<char> buffer(dwSize + 1);
-            if (WinHttpReadData(hRequest, buffer.data(), dwSize, &dwDownloaded)) {
-                buffer[dwDownloaded] = 0;
-                result.append(buffer.data());
-            }
-        } while (dwSize > 0);
-    }
-    else {
-        OutputDebugStringA("WinHttp request failed\n");
-    }
-
-    WinHttpCloseHandle(hRequest);
-    WinHttpCloseHandle(hConnect);
-    WinHttpCloseHandle(hSession);
-
-    return result;
+Player::~Player() {
+    Shutdown();
 }
 
-static std::string UrlEncode(const std::string& value) {
-    std::ostringstream escaped;
-    escaped.fill('0');
-    escaped << std::hex;
+Task<void> PlayerInfo::UpdateUrlsAsync(CatalogIndex* catalog) {
+    // Known albums resolve offline from the local index
+    if (catalog) {
+        if (auto entry = catalog->Find(artist, albumTitle)) {
+            if (!entry->thumbnailUrl.empty()) thumbnailUrl = entry->thumbnailUrl;
+            if (!entry->albumUrl.empty()) albumUrl = entry->albumUrl;
 
-    for (const auto& c : value) {
-        if (isalnum((unsigned char)c) || c == '-' || c == '_' || c == '.' || c == '~') {
-            escaped << c;
-        }
-        else if (c == ' ') {
-            escaped << '+';
-        }
-        else {
-            escaped << '%' << std::setw(2) << std::uppercase << int((unsigned char)c);
+            if (thumbnailUrl.has_value() && albumUrl.has_value()) co_return;
         }
     }
-    return escaped.str();
-}
 
-void PlayerInfo::UpdateUrls() {
     // Compose search term from artist + album
     std::string artistUtf8 = WideToUTF8(artist);
     std::string albumUtf8 = WideToUTF8(albumTitle);
@@ -299,7 +479,7 @@ void PlayerInfo::UpdateUrls() {
 
     const std::string& jsonUrl = "https://itunes.apple.com/search?term=" + encodedTerm + "&entity=album&limit=1";
 
-    auto jsonResponse = HttpGet(std::wstring(jsonUrl.begin(), jsonUrl.end()));
+    auto jsonResponse = co_await HttpGetAsync(std::wstring(jsonUrl.begin(), jsonUrl.end()));
 
     try {
         auto json = nlohmann::json::parse(jsonResponse);
@@ -321,4 +501,8 @@ void PlayerInfo::UpdateUrls() {
     catch (const std::exception& e) {
         OutputDebugStringA(("JSON parse error: " + std::string(e.what()) + "\n").c_str());
     }
+
+    if (catalog && (thumbnailUrl.has_value() || albumUrl.has_value())) {
+        catalog->Add(artist, albumTitle, { thumbnailUrl.value_or(""), albumUrl.value_or("") });
+    }
 }
\ No newline at end of file
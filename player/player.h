@@ -1,5 +1,8 @@
 #pragma once
 #include "player-types.h"
+#include "player-timeline.h"
+#include "play-tracker.h"
+#include "../async/task-tracker.h"
 
 #include <condition_variable>
 #include <mutex>
@@ -10,13 +13,38 @@ class Player {
 
 		std::mutex m_trackMutex;
 		std::shared_ptr<PlayerInfo> m_currentTrack;
+		PlayerTimeline m_timeline;
+		PlayTracker m_playTracker;
 
 		PlayerInfoHandler m_playerHandler;
+		PlayFinishedHandler m_playFinishedHandler;
+		std::function<void()> m_stateChangedHandler;
+		std::shared_ptr<CatalogIndex> m_catalog;
+
+		// SMTC callbacks and the session reads they start; Shutdown cancels and joins them
+		TaskTracker m_tasks;
+
+		// Bumped per session read so an older read that resumes late is dropped instead of overwriting a newer one
+		std::atomic<uint64_t> m_sessionGeneration{ 0 };
+
+		// Replacing a revoker unsubscribes the previous handler, so each event has at most one subscription
+		std::mutex m_sessionMutex;
+		GlobalSystemMediaTransportControlsSessionManager::SessionsChanged_revoker m_sessionsChangedRevoker;
+		GlobalSystemMediaTransportControlsSession::PlaybackInfoChanged_revoker m_playbackInfoRevoker;
+		GlobalSystemMediaTransportControlsSession::MediaPropertiesChanged_revoker m_mediaPropertiesRevoker;
+		GlobalSystemMediaTransportControlsSession::TimelinePropertiesChanged_revoker m_timelinePropertiesRevoker;
 
 	private:
-		void SCMTC_ProcessSession(winrt::Windows::Media::Control::GlobalSystemMediaTransportControlsSession session);
+		Task<void> ProcessSessionAsync(winrt::Windows::Media::Control::GlobalSystemMediaTransportControlsSession session);
 		void OnPlaybackInfoChanged(winrt::Windows::Media::Control::GlobalSystemMediaTransportControlsSession sender, winrt::Windows::Foundation::IInspectable const&);
 		void OnMediaPropertiesChanged(winrt::Windows::Media::Control::GlobalSystemMediaTransportControlsSession sender, winrt::Windows::Foundation::IInspectable const&);
+		void OnTimelinePropertiesChanged(winrt::Windows::Media::Control::GlobalSystemMediaTransportControlsSession sender, winrt::Windows::Foundation::IInspectable const&);
+
+		void ApplyTimeline(PlayerInfo& track) const;
+
+		// StaticFlags == DynamicFlags reads the runtime flags; anything else fixes the fields at compile time
+		template <uint32_t StaticFlags>
+		Task<bool> UpdateAsync(PlayerForceUpdateFlags flags, PlayerInfo& out, bool callHandler);
 
 		bool CheckForAppleMusicSession();
 		bool HandleSessionsChanged();
@@ -29,11 +57,40 @@ class Player {
 
 
 	public:
+		static constexpr uint32_t DynamicFlags = ~0u;
+
 		Player() = default;
 		~Player();
 
 		void Initialize();
+		Task<void> InitializeAsync();
+
+		// Unsubscribes from SMTC and waits for in-flight session reads; the handlers are not called afterwards
+		void Shutdown();
 		void SetPlayerInfoHandler(PlayerInfoHandler handler);
+		void SetPlayFinishedHandler(PlayFinishedHandler handler);
+
+		// Called after the session is attached/detached or its playback state changes
+		void SetStateChangedHandler(std::function<void()> handler);
+		void SetCatalogIndex(std::shared_ptr<CatalogIndex> catalog);
 		bool isValidTrack();
+		bool NeedsTimelineSample();
+		std::optional<GlobalSystemMediaTransportControlsSessionPlaybackStatus> GetPlaybackStatus();
+		std::wstring GetCurrentArtist();
+		// Returns an empty track if there is no session; callers that refresh often should use
+		// ForceUpdateAsync with a reused PlayerInfo to keep the string buffers
 		PlayerInfo ForceUpdate(PlayerForceUpdateFlags flags = PlayerForceUpdateFlags::None, bool callHandler = true);
+
+		// Coroutine form of ForceUpdate; out receives the refreshed track, returns false if there is none
+		Task<bool> ForceUpdateAsync(PlayerForceUpdateFlags flags, PlayerInfo& out, bool callHandler = true);
+
+		// Compile-time field selection: only the source queries and field writes for Flags are generated.
+		// Instantiated in player.cpp for the combinations in use.
+		template <PlayerForceUpdateFlags Flags>
+		Task<bool> RefreshAsync(PlayerInfo& out, bool callHandler = true) {
+			return UpdateAsync<Flags>(Flags, out, callHandler);
+		}
+
+		template <PlayerForceUpdateFlags Flags>
+		PlayerInfo Refresh(bool callHandler = true);
 };
\ No newline at end of file
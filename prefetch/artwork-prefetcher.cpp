@@ -0,0 +1,254 @@
+#include "artwork-prefetcher.h"
+
+#include <windows.h>
+#include <algorithm>
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+#include <winrt/Windows.Foundation.h>
+
+#include "../catalog/catalog-index.h"
+#include "../history/listening-history.h"
+#include "../http/http-client.h"
+#include "../strings/string-utils.h"
+
+ArtworkPrefetcher::ArtworkPrefetcher(std::shared_ptr<CatalogIndex> catalog, std::shared_ptr<ListeningHistory> history, std::wstring statePath)
+    : m_catalog(std::move(catalog)), m_history(std::move(history)), m_statePath(std::move(statePath)) {
+}
+
+// The state file holds wall-clock Unix ms; the budget itself runs on the steady clock
+static int64_t ToUnixMs(std::chrono::steady_clock::time_point time, std::chrono::steady_clock::time_point steadyNow,
+    std::chrono::system_clock::time_point systemNow) {
+    auto wall = systemNow - std::chrono::duration_cast<std::chrono::system_clock::duration>(steadyNow - time);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(wall.time_since_epoch()).count();
+}
+
+static std::chrono::steady_clock::time_point FromUnixMs(int64_t ms, std::chrono::steady_clock::time_point steadyNow,
+    std::chrono::system_clock::time_point systemNow) {
+    auto age = systemNow - std::chrono::system_clock::time_point(std::chrono::milliseconds(ms));
+
+    // A clock set backwards must not push entries into the future and stall the budget
+    if (age < std::chrono::system_clock::duration::zero()) age = std::chrono::system_clock::duration::zero();
+    return steadyNow - std::chrono::duration_cast<std::chrono::steady_clock::duration>(age);
+}
+
+void ArtworkPrefetcher::LoadState() {
+    std::ifstream in(m_statePath, std::ios::binary);
+    if (!in) return;
+
+    auto steadyNow = std::chrono::steady_clock::now();
+    auto systemNow = std::chrono::system_clock::now();
+
+    try {
+        auto state = nlohmann::json::parse(in);
+
+        for (const auto& sent : state.value("requests", nlohmann::json::array())) {
+            auto time = FromUnixMs(sent.get<int64_t>(), steadyNow, systemNow);
+            if (steadyNow - time < std::chrono::hours(1)) m_requestTimes.push_back(time);
+        }
+        std::sort(m_requestTimes.begin(), m_requestTimes.end());
+
+        for (const auto& [artist, fetchedAt] : state.value("fetched", nlohmann::json::object()).items()) {
+            auto time = FromUnixMs(fetchedAt.get<int64_t>(), steadyNow, systemNow);
+            if (steadyNow - time < ArtistRefreshInterval) m_fetched[UTF8ToWide(artist)] = time;
+        }
+    }
+    catch (const std::exception& e) {
+        // A torn file only costs the remembered budget
+        m_requestTimes.clear();
+        m_fetched.clear();
+        OutputDebugStringA(("ArtworkPrefetcher: ignoring saved state: " + std::string(e.what()) + "\n").c_str());
+    }
+}
+
+void ArtworkPrefetcher::SaveState() {
+    auto steadyNow = std::chrono::steady_clock::now();
+    auto systemNow = std::chrono::system_clock::now();
+
+    nlohmann::json requests = nlohmann::json::array();
+    for (auto time : m_requestTimes) {
+        requests.push_back(ToUnixMs(time, steadyNow, systemNow));
+    }
+
+    nlohmann::json fetched = nlohmann::json::object();
+    for (const auto& [artist, time] : m_fetched) {
+        if (steadyNow - time < ArtistRefreshInterval) fetched[WideToUTF8(artist)] = ToUnixMs(time, steadyNow, systemNow);
+    }
+
+    std::wstring tempPath = m_statePath + L".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) return;
+        out << nlohmann::json{ {"requests", requests}, {"fetched", fetched} }.dump();
+        if (!out.good()) return;
+    }
+
+    if (!MoveFileExW(tempPath.c_str(), m_statePath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        DeleteFileW(tempPath.c_str());
+        OutputDebugStringA("ArtworkPrefetcher: failed to save state.\n");
+    }
+}
+
+ArtworkPrefetcher::~ArtworkPrefetcher() {
+    Stop();
+}
+
+void ArtworkPrefetcher::Start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_thread.joinable()) return;
+
+    m_stopping = false;
+    LoadState();
+    m_thread = std::thread([this] {
+        winrt::init_apartment(winrt::apartment_type::multi_threaded);
+        Run();
+        winrt::uninit_apartment();
+        });
+}
+
+void ArtworkPrefetcher::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_one();
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void ArtworkPrefetcher::SetIdle(bool idle, const std::wstring& currentArtist) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_idle == idle && (currentArtist.empty() || m_currentArtist == currentArtist)) return;
+
+        m_idle = idle;
+        if (!currentArtist.empty()) m_currentArtist = currentArtist;
+    }
+    m_cv.notify_one();
+}
+
+std::chrono::steady_clock::time_point ArtworkPrefetcher::NextAllowedRequest(std::chrono::steady_clock::time_point now) {
+    while (!m_requestTimes.empty() && now - m_requestTimes.front() >= std::chrono::hours(1)) {
+        m_requestTimes.pop_front();
+    }
+
+    if (m_requestTimes.empty()) return now;
+
+    auto next = m_requestTimes.back() + MinRequestSpacing;
+    if (m_requestTimes.size() >= MaxRequestsPerHour) {
+        next = (std::max)(next, m_requestTimes.front() + std::chrono::hours(1));
+    }
+    return (std::max)(next, now);
+}
+
+bool ArtworkPrefetcher::NextCandidate(std::wstring& artist) {
+    auto now = std::chrono::steady_clock::now();
+    auto due = [&](const std::wstring& name) {
+        if (name.empty()) return false;
+        auto it = m_fetched.find(name);
+        return it == m_fetched.end() || now - it->second >= ArtistRefreshInterval;
+    };
+
+    if (due(m_currentArtist)) {
+        artist = m_currentArtist;
+        return true;
+    }
+
+    if (m_history) {
+        auto to = std::chrono::system_clock::now();
+        auto from = to - std::chrono::hours(24 * 30);
+        for (const auto& top : m_history->TopArtists(from, to, TopArtistCount)) {
+            if (due(top.artist)) {
+                artist = top.artist;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void ArtworkPrefetcher::Run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (!m_stopping) {
+        // Nothing happens while music is playing: track changes own the network then
+        if (!m_idle) {
+            m_cv.wait(lock, [this] { return m_stopping || m_idle; });
+            continue;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        auto allowedAt = NextAllowedRequest(now);
+        if (now < allowedAt) {
+            m_cv.wait_until(lock, allowedAt, [this] { return m_stopping || !m_idle; });
+            continue;
+        }
+
+        std::wstring artist;
+        if (!NextCandidate(artist)) {
+            // Everything is warm; wait for a new current artist or the next idle period
+            std::wstring seenArtist = m_currentArtist;
+            m_cv.wait(lock, [&] { return m_stopping || !m_idle || m_currentArtist != seenArtist; });
+            continue;
+        }
+
+        m_fetched[artist] = now;
+        m_requestTimes.push_back(now);
+        ++m_requests;
+
+        // Saved before the request goes out, so a crash mid-request still counts it
+        SaveState();
+
+        lock.unlock();
+        size_t added = Prefetch(artist);
+        lock.lock();
+
+        m_albumsAdded += added;
+        OutputDebugStringA(("ArtworkPrefetcher: " + std::to_string(added) + " albums warmed (" + std::to_string(m_albumsAdded)
+            + " total over " + std::to_string(m_requests) + " requests)\n").c_str());
+    }
+}
+
+size_t ArtworkPrefetcher::Prefetch(const std::wstring& artist) {
+    std::string url = "https://itunes.apple.com/search?term=" + UrlEncode(WideToUTF8(artist))
+        + "&entity=album&attribute=artistTerm&limit=" + std::to_string(AlbumsPerArtist);
+
+    std::string response = SyncWait(HttpGetAsync(std::wstring(url.begin(), url.end())));
+    if (response.empty()) return 0;
+
+    size_t added = 0;
+    try {
+        auto json = nlohmann::json::parse(response);
+        if (!json.contains("results")) return 0;
+
+        // artistTerm also matches collaborations and similarly named artists; only exact (normalized) matches
+        // may be stored under this artist, or a lookup would serve another artist's album until a track change
+        // overwrites it (Add keeps the latest entry)
+        std::string wantedArtist = CatalogIndex::NormalizeKey(artist, {});
+
+        for (const auto& result : json["results"]) {
+            std::wstring resultArtist = UTF8ToWide(result.value("artistName", ""));
+            if (CatalogIndex::NormalizeKey(resultArtist, {}) != wantedArtist) continue;
+
+            std::wstring album = UTF8ToWide(result.value("collectionName", ""));
+            if (album.empty()) continue;
+
+            // Keyed by the artist string the media session reports, which is what lookups use
+            if (m_catalog->Find(artist, album)) continue;
+
+            CatalogEntry entry{ result.value("artworkUrl100", ""), result.value("collectionViewUrl", "") };
+            if (entry.thumbnailUrl.empty() && entry.albumUrl.empty()) continue;
+
+            m_catalog->Add(artist, album, entry);
+            ++added;
+        }
+    }
+    catch (const std::exception& e) {
+        OutputDebugStringA(("ArtworkPrefetcher: " + std::string(e.what()) + "\n").c_str());
+    }
+
+    return added;
+}
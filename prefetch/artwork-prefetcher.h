@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+class CatalogIndex;
+class ListeningHistory;
+
+// Warms the catalog index with album artwork/URLs for artists likely to be played next
+// (the current artist, then the most played ones), so a track change resolves offline.
+// Works only while playback is idle or paused and never exceeds its request budget. The budget and
+// per-artist fetch times are saved to statePath, so restarting the app does not reset them.
+class ArtworkPrefetcher {
+public:
+    ArtworkPrefetcher(std::shared_ptr<CatalogIndex> catalog, std::shared_ptr<ListeningHistory> history, std::wstring statePath);
+    ~ArtworkPrefetcher();
+
+    ArtworkPrefetcher(const ArtworkPrefetcher&) = delete;
+    ArtworkPrefetcher& operator=(const ArtworkPrefetcher&) = delete;
+
+    void Start();
+    void Stop();
+
+    // currentArtist, when given, is prefetched ahead of the history-based candidates
+    void SetIdle(bool idle, const std::wstring& currentArtist = {});
+
+private:
+    static constexpr size_t MaxRequestsPerHour = 6;
+    static constexpr std::chrono::seconds MinRequestSpacing{ 60 };
+    static constexpr std::chrono::hours ArtistRefreshInterval{ 24 };
+    static constexpr size_t TopArtistCount = 10;
+    static constexpr int AlbumsPerArtist = 25;
+
+    std::shared_ptr<CatalogIndex> m_catalog;
+    std::shared_ptr<ListeningHistory> m_history;
+    std::wstring m_statePath;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stopping = false;
+    bool m_idle = false;
+    std::wstring m_currentArtist;
+    std::thread m_thread;
+
+    // Budget bookkeeping: send times within the last hour, and when each artist was last fetched
+    std::deque<std::chrono::steady_clock::time_point> m_requestTimes;
+    std::unordered_map<std::wstring, std::chrono::steady_clock::time_point> m_fetched;
+
+    uint64_t m_requests = 0;
+    uint64_t m_albumsAdded = 0;
+
+    void LoadState();
+    void SaveState(); // Called with m_mutex held
+    void Run();
+    bool NextCandidate(std::wstring& artist);
+    std::chrono::steady_clock::time_point NextAllowedRequest(std::chrono::steady_clock::time_point now);
+    size_t Prefetch(const std::wstring& artist);
+};
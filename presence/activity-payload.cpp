@@ -0,0 +1,95 @@
+#include "activity-payload.h"
+#include "../discord-ipc/json-writer.h"
+#include "../strings/string-utils.h"
+
+#include <chrono>
+
+void BuildActivityPayload(const PlayerInfo& info, const PresenceTemplates& templates, std::pmr::string& out)
+{
+    using PlaybackStatus = winrt::Windows::Media::Control::GlobalSystemMediaTransportControlsSessionPlaybackStatus;
+
+	const int& type = 2; // Default to Listening
+
+    auto now = std::chrono::system_clock::now();
+    auto nowSeconds = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+
+    int64_t posSeconds = std::chrono::duration_cast<std::chrono::seconds>(info.position).count();
+    int64_t durSeconds = std::chrono::duration_cast<std::chrono::seconds>(info.duration).count();
+
+    std::pmr::memory_resource* resource = out.get_allocator().resource();
+    std::pmr::string title(resource), artist(resource), album(resource);
+    WideToUTF8(info.title, title);
+    WideToUTF8(info.artist, artist);
+    WideToUTF8(info.albumTitle, album);
+
+    PresenceValues values;
+    values.title = title;
+    values.artist = artist;
+    values.album = album;
+    values.durationSeconds = durSeconds;
+    values.playing = info.playbackStatus == PlaybackStatus::Playing;
+    values.paused = info.playbackStatus == PlaybackStatus::Paused;
+
+    // Text fields come from the compiled templates; an empty result leaves the field out
+    std::pmr::string field(resource);
+    auto writeTemplate = [&](const char* key, const PresenceTemplate& presenceTemplate, JsonWriter<std::pmr::string>& writer) {
+        field.clear();
+        presenceTemplate.Render(values, field);
+        if (field.empty()) return;
+
+        writer.Key(key);
+        writer.String(field);
+    };
+
+    JsonWriter<std::pmr::string> writer(out);
+    writer.BeginObject();
+
+    writer.Key("type");
+    writer.Int(type); // Listening
+
+    writeTemplate("details", templates.details, writer);
+    writeTemplate("state", templates.state, writer);
+
+    writer.Key("assets");
+    writer.BeginObject();
+
+    writeTemplate("large_text", templates.largeText, writer);
+
+    // Set album cover or fallback image
+    writer.Key("large_image");
+    writer.String((info.thumbnailUrl.has_value() && !info.thumbnailUrl->empty())
+        ? std::string_view(*info.thumbnailUrl)
+        : std::string_view("apple_music_logo"));
+
+    writer.EndObject();
+
+    writer.Key("buttons");
+    writer.BeginArray();
+    writer.BeginObject();
+    writer.Key("label");
+    writer.String("Play on Music");
+    writer.Key("url");
+    writer.String(info.albumUrl.has_value() && !info.albumUrl->empty()
+        ? std::string_view(*info.albumUrl)
+        : std::string_view("https://music.apple.com/"));
+    writer.EndObject();
+    writer.EndArray();
+
+    if (info.playbackStatus == PlaybackStatus::Playing) {
+        // Prefer the anchored start so timestamps don't jitter between updates
+        int64_t startTime = (info.startTime.time_since_epoch().count() != 0)
+            ? std::chrono::duration_cast<std::chrono::seconds>(info.startTime.time_since_epoch()).count()
+            : nowSeconds - posSeconds;
+        int64_t endTime = startTime + durSeconds;
+
+        writer.Key("timestamps");
+        writer.BeginObject();
+        writer.Key("start");
+        writer.Int(startTime);
+        writer.Key("end");
+        writer.Int(endTime);
+        writer.EndObject();
+    }
+
+    writer.EndObject();
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "../player/player-types.h"
+#include "presence-template.h"
+
+#include <memory_resource>
+#include <string>
+
+// Serializes the Discord activity for info straight into out; temporaries share out's memory resource,
+// so with an arena-backed string a steady-state update makes no global heap allocations.
+void BuildActivityPayload(const PlayerInfo& info, const PresenceTemplates& templates, std::pmr::string& out);
@@ -0,0 +1,210 @@
+#include "presence-template.h"
+
+#include <windows.h>
+#include <algorithm>
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+
+static const char* DefaultDetails = "{title}";
+static const char* DefaultState = "{?paused}Paused | {/}{artist}";
+static const char* DefaultLargeText = "{album}";
+
+std::optional<PresenceTemplate> PresenceTemplate::Compile(std::string_view source, size_t maxLength) {
+    static constexpr std::pair<std::string_view, uint8_t> fields[] = {
+        { "title", Title }, { "artist", Artist }, { "album", Album }, { "status", Status }, { "duration", Duration }
+    };
+    static constexpr std::pair<std::string_view, uint8_t> conditions[] = {
+        { "playing", Playing }, { "paused", Paused }, { "title", HasTitle }, { "artist", HasArtist }, { "album", HasAlbum }
+    };
+
+    auto fail = [&](const std::string& message) {
+        OutputDebugStringA(("PresenceTemplate: " + message + " in \"" + std::string(source) + "\"\n").c_str());
+        return std::nullopt;
+    };
+
+    PresenceTemplate compiled;
+    compiled.m_maxLength = maxLength;
+
+    std::vector<size_t> openBlocks;
+    size_t literalStart = std::string::npos;
+
+    auto flushLiteral = [&] {
+        if (literalStart == std::string::npos) return;
+        compiled.m_code.push_back({ Op::Literal, 0, static_cast<uint32_t>(literalStart),
+            static_cast<uint32_t>(compiled.m_literals.size() - literalStart) });
+        literalStart = std::string::npos;
+    };
+    auto appendLiteral = [&](char c) {
+        if (literalStart == std::string::npos) literalStart = compiled.m_literals.size();
+        compiled.m_literals += c;
+    };
+
+    for (size_t i = 0; i < source.size(); ++i) {
+        if (source[i] != '{') {
+            appendLiteral(source[i]);
+            continue;
+        }
+
+        if (i + 1 < source.size() && source[i + 1] == '{') {
+            appendLiteral('{');
+            ++i;
+            continue;
+        }
+
+        size_t close = source.find('}', i);
+        if (close == std::string_view::npos) return fail("unterminated '{'");
+
+        std::string_view tag = source.substr(i + 1, close - i - 1);
+        i = close;
+        flushLiteral();
+
+        if (tag == "/") {
+            if (openBlocks.empty()) return fail("'{/}' without an open block");
+            compiled.m_code[openBlocks.back()].offset = static_cast<uint32_t>(compiled.m_code.size());
+            openBlocks.pop_back();
+            continue;
+        }
+
+        if (!tag.empty() && (tag[0] == '?' || tag[0] == '!')) {
+            std::string_view name = tag.substr(1);
+            auto it = std::find_if(std::begin(conditions), std::end(conditions), [&](const auto& c) { return c.first == name; });
+            if (it == std::end(conditions)) return fail("unknown condition '" + std::string(name) + "'");
+
+            openBlocks.push_back(compiled.m_code.size());
+            compiled.m_code.push_back({ Op::JumpUnless, it->second, 0, tag[0] == '!' ? 1u : 0u });
+            continue;
+        }
+
+        auto it = std::find_if(std::begin(fields), std::end(fields), [&](const auto& f) { return f.first == tag; });
+        if (it == std::end(fields)) return fail("unknown placeholder '" + std::string(tag) + "'");
+
+        compiled.m_code.push_back({ Op::Field, it->second, 0, 0 });
+    }
+
+    flushLiteral();
+    if (!openBlocks.empty()) return fail("missing '{/}'");
+
+    return compiled;
+}
+
+bool PresenceTemplate::Test(const PresenceValues& values, uint8_t cond) {
+    switch (cond) {
+    case Playing: return values.playing;
+    case Paused: return values.paused;
+    case HasTitle: return !values.title.empty();
+    case HasArtist: return !values.artist.empty();
+    case HasAlbum: return !values.album.empty();
+    default: return false;
+    }
+}
+
+void PresenceTemplate::AppendField(const PresenceValues& values, uint8_t field, std::pmr::string& out) {
+    switch (field) {
+    case Title: out += values.title; break;
+    case Artist: out += values.artist; break;
+    case Album: out += values.album; break;
+    case Status: out += values.playing ? "Playing" : values.paused ? "Paused" : "Stopped"; break;
+
+    case Duration: {
+        // m:ss, formatted by hand to stay off the heap
+        int64_t total = values.durationSeconds > 0 ? values.durationSeconds : 0;
+        char buffer[24];
+        char* end = buffer + sizeof(buffer);
+        char* p = end;
+
+        int64_t seconds = total % 60;
+        *--p = static_cast<char>('0' + seconds % 10);
+        *--p = static_cast<char>('0' + seconds / 10);
+        *--p = ':';
+
+        int64_t minutes = total / 60;
+        do {
+            *--p = static_cast<char>('0' + minutes % 10);
+            minutes /= 10;
+        } while (minutes > 0);
+
+        out.append(p, end);
+        break;
+    }
+    }
+}
+
+void PresenceTemplate::Truncate(std::pmr::string& out, size_t start, size_t maxLength) {
+    if (maxLength == 0) return;
+
+    // Count characters (UTF-8 lead bytes) and remember where the last one that still leaves room for "..." begins
+    size_t characters = 0;
+    size_t cut = std::string::npos;
+    for (size_t i = start; i < out.size(); ++i) {
+        if ((static_cast<unsigned char>(out[i]) & 0xC0) == 0x80) continue;
+
+        if (characters == maxLength - 1) cut = i;
+        if (++characters > maxLength) {
+            out.resize(cut);
+            out += "\xE2\x80\xA6"; // U+2026
+            return;
+        }
+    }
+}
+
+void PresenceTemplate::Render(const PresenceValues& values, std::pmr::string& out) const {
+    size_t start = out.size();
+
+    for (size_t pc = 0; pc < m_code.size(); ++pc) {
+        const Instruction& instruction = m_code[pc];
+
+        switch (instruction.op) {
+        case Op::Literal:
+            out.append(m_literals, instruction.offset, instruction.length);
+            break;
+
+        case Op::Field:
+            AppendField(values, instruction.arg, out);
+            break;
+
+        case Op::JumpUnless:
+            if (Test(values, instruction.arg) == (instruction.length != 0)) {
+                pc = instruction.offset - 1; // Loop increment lands on the block's end
+            }
+            break;
+        }
+    }
+
+    Truncate(out, start, m_maxLength);
+}
+
+PresenceTemplates PresenceTemplates::Defaults() {
+    PresenceTemplates templates;
+    templates.details = *PresenceTemplate::Compile(DefaultDetails, MaxFieldLength);
+    templates.state = *PresenceTemplate::Compile(DefaultState, MaxFieldLength);
+    templates.largeText = *PresenceTemplate::Compile(DefaultLargeText, MaxFieldLength);
+    return templates;
+}
+
+PresenceTemplates PresenceTemplates::Load(const std::wstring& path) {
+    PresenceTemplates templates = Defaults();
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return templates;
+
+    try {
+        auto json = nlohmann::json::parse(in);
+
+        auto apply = [&](const char* key, PresenceTemplate& target) {
+            if (!json.contains(key) || !json[key].is_string()) return;
+            if (auto compiled = PresenceTemplate::Compile(json[key].get<std::string>(), MaxFieldLength)) {
+                target = std::move(*compiled);
+            }
+        };
+
+        apply("details", templates.details);
+        apply("state", templates.state);
+        apply("largeText", templates.largeText);
+    }
+    catch (const std::exception& e) {
+        OutputDebugStringA(("PresenceTemplates: " + std::string(e.what()) + "\n").c_str());
+    }
+
+    return templates;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Values a template can refer to; strings are UTF-8 and only borrowed for the render
+struct PresenceValues {
+    std::string_view title;
+    std::string_view artist;
+    std::string_view album;
+    int64_t durationSeconds = 0;
+    bool playing = false;
+    bool paused = false;
+};
+
+// One activity field, compiled once from a template such as "{?paused}Paused | {/}{artist}".
+//
+//   {title} {artist} {album} {status} {duration}   placeholders
+//   {?cond}...{/}  {!cond}...{/}                   conditional block, cond is playing, paused or a field name (non-empty)
+//   {{                                             literal '{'
+//
+// Rendering walks a flat instruction list and writes straight into the caller's string, so it neither
+// parses nor allocates beyond that string's own resource.
+class PresenceTemplate {
+public:
+    PresenceTemplate() = default;
+
+    // Returns nothing (and logs) on a syntax error
+    static std::optional<PresenceTemplate> Compile(std::string_view source, size_t maxLength);
+
+    // Output is cut to maxLength characters, ending in an ellipsis when truncated
+    void Render(const PresenceValues& values, std::pmr::string& out) const;
+
+private:
+    enum class Op : uint8_t {
+        Literal,   // m_literals[offset, offset + length)
+        Field,     // arg = FieldId
+        JumpUnless // arg = CondId, negate flag in length; offset = instruction index to jump to
+    };
+
+    enum FieldId : uint8_t { Title, Artist, Album, Status, Duration };
+    enum CondId : uint8_t { Playing, Paused, HasTitle, HasArtist, HasAlbum };
+
+    struct Instruction {
+        Op op;
+        uint8_t arg;
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    std::string m_literals;
+    std::vector<Instruction> m_code;
+    size_t m_maxLength = 0;
+
+    static bool Test(const PresenceValues& values, uint8_t cond);
+    static void AppendField(const PresenceValues& values, uint8_t field, std::pmr::string& out);
+    static void Truncate(std::pmr::string& out, size_t start, size_t maxLength);
+};
+
+// Per-field templates for the activity, read from presence-templates.json; missing or invalid fields keep the defaults
+struct PresenceTemplates {
+    // Discord rejects details/state/large_text longer than this
+    static constexpr size_t MaxFieldLength = 128;
+
+    PresenceTemplate details;
+    PresenceTemplate state;
+    PresenceTemplate largeText;
+
+    static PresenceTemplates Defaults();
+    static PresenceTemplates Load(const std::wstring& path);
+};
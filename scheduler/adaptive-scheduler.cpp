@@ -0,0 +1,77 @@
+#include "adaptive-scheduler.h"
+
+#include <algorithm>
+
+AdaptiveScheduler::AdaptiveScheduler(Clock::time_point now)
+    : m_stateSince(now), m_nextDiscordAttempt(now), m_nextTimelinePoll(now) {
+}
+
+AdaptiveScheduler::Actions AdaptiveScheduler::Wake(const SchedulerInputs& inputs, Clock::time_point now) {
+    Actions actions;
+
+    if (!m_firstPass) ++m_wakeups;
+    m_firstPass = false;
+
+    SchedulerState state = !inputs.attached ? SchedulerState::NoSession
+        : inputs.playing ? SchedulerState::Playing
+        : SchedulerState::Idle;
+
+    if (state != m_state) {
+        actions.finished = SchedulerPeriod{ m_state, m_wakeups, now - m_stateSince };
+        m_state = state;
+        m_stateSince = now;
+        m_wakeups = 0;
+        m_nextDiscordAttempt = now;
+    }
+
+    switch (m_state) {
+    case SchedulerState::NoSession:
+        break;
+
+    case SchedulerState::Idle:
+        // One attempt per event so a paused track still shows up, but no retry timer
+        actions.connectDiscord = !inputs.discordConnected;
+        break;
+
+    case SchedulerState::Playing:
+        // If the attempt succeeds NextDeadline ignores the retry time, so it can be set up front
+        if (!inputs.discordConnected && now >= m_nextDiscordAttempt) {
+            actions.connectDiscord = true;
+            m_nextDiscordAttempt = now + DiscordRetry;
+        }
+
+        // Timeline changes arrive as events; only poll while the source has not reported a duration yet,
+        // doubling the interval up to MaxTimelinePoll
+        if (inputs.needsTimelineSample) {
+            if (now >= m_nextTimelinePoll) {
+                actions.pollTimeline = true;
+                m_nextTimelinePoll = now + m_timelinePollInterval;
+                m_timelinePollInterval = (std::min)(m_timelinePollInterval * 2, Clock::duration(MaxTimelinePoll));
+            }
+        }
+        else {
+            m_timelinePollInterval = FirstTimelinePoll;
+            m_nextTimelinePoll = now;
+        }
+        break;
+    }
+
+    return actions;
+}
+
+std::optional<AdaptiveScheduler::Clock::time_point> AdaptiveScheduler::NextDeadline(const SchedulerInputs& inputs) const {
+    if (m_state != SchedulerState::Playing) return std::nullopt;
+
+    std::optional<Clock::time_point> deadline;
+    if (!inputs.discordConnected) {
+        deadline = m_nextDiscordAttempt;
+    }
+    if (inputs.needsTimelineSample) {
+        deadline = deadline ? (std::min)(*deadline, m_nextTimelinePoll) : m_nextTimelinePoll;
+    }
+    return deadline;
+}
+
+SchedulerPeriod AdaptiveScheduler::Finish(Clock::time_point now) const {
+    return SchedulerPeriod{ m_state, m_wakeups, now - m_stateSince };
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+enum class SchedulerState { NoSession, Idle, Playing };
+
+// What the Init loop observed on this pass
+struct SchedulerInputs {
+    bool attached = false;          // An Apple Music session is attached
+    bool playing = false;
+    bool discordConnected = false;
+    bool needsTimelineSample = false; // The source has not reported a duration yet
+};
+
+// Wakeups spent in one state, reported when the state is left
+struct SchedulerPeriod {
+    SchedulerState state = SchedulerState::NoSession;
+    size_t wakeups = 0;
+    std::chrono::steady_clock::duration elapsed{};
+};
+
+// Decides, for the Init loop, what to do on each pass and when it has to wake again without an event. Only
+// Playing with something outstanding (Discord to find, a timeline to sample) arms a timer; NoSession and Idle
+// sleep until an event arrives. Time is passed in, so the policy can be driven by a simulated clock.
+class AdaptiveScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::seconds DiscordRetry{ 5 };
+    static constexpr std::chrono::seconds FirstTimelinePoll{ 1 };
+    static constexpr std::chrono::seconds MaxTimelinePoll{ 32 };
+
+    struct Actions {
+        std::optional<SchedulerPeriod> finished; // Set when this pass left a state
+        bool connectDiscord = false;
+        bool pollTimeline = false;
+    };
+
+    explicit AdaptiveScheduler(Clock::time_point now);
+
+    // Called once per loop pass; every pass after the first follows a wait and counts as a wakeup
+    Actions Wake(const SchedulerInputs& inputs, Clock::time_point now);
+
+    // When to wake without an event, given the inputs after the actions ran; nothing means events only
+    std::optional<Clock::time_point> NextDeadline(const SchedulerInputs& inputs) const;
+
+    // Closes the current period, for the report at shutdown
+    SchedulerPeriod Finish(Clock::time_point now) const;
+
+    SchedulerState State() const { return m_state; }
+
+private:
+    SchedulerState m_state = SchedulerState::NoSession;
+    Clock::time_point m_stateSince;
+    size_t m_wakeups = 0;
+    bool m_firstPass = true;
+
+    Clock::time_point m_nextDiscordAttempt;
+    Clock::duration m_timelinePollInterval = FirstTimelinePoll;
+    Clock::time_point m_nextTimelinePoll;
+};
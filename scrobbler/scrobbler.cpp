@@ -0,0 +1,288 @@
+#include "scrobbler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <nlohmann/json.hpp>
+#include <winrt/Windows.Foundation.h>
+
+#include "../http/http-client.h"
+#include "../strings/string-utils.h"
+
+std::optional<ScrobblerConfig> ScrobblerConfig::Load(const std::wstring& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return std::nullopt;
+
+    try {
+        auto json = nlohmann::json::parse(in);
+
+        ScrobblerConfig config;
+        config.endpoint = UTF8ToWide(json.value("endpoint", ""));
+        config.authorization = UTF8ToWide(json.value("authorization", ""));
+        config.batchSize = (std::max)(json.value("batchSize", config.batchSize), size_t(1));
+
+        // Durations are configured in whole seconds
+        auto seconds = [&](const char* key, std::chrono::milliseconds fallback) {
+            auto fallbackSeconds = std::chrono::duration_cast<std::chrono::seconds>(fallback).count();
+            return std::chrono::milliseconds(std::chrono::seconds(json.value(key, static_cast<int64_t>(fallbackSeconds))));
+        };
+        config.maxDelay = seconds("maxDelaySeconds", config.maxDelay);
+        config.minBackoff = seconds("minBackoffSeconds", config.minBackoff);
+        config.maxBackoff = (std::max)(seconds("maxBackoffSeconds", config.maxBackoff), config.minBackoff);
+
+        if (config.endpoint.empty()) return std::nullopt;
+        return config;
+    }
+    catch (const std::exception& e) {
+        OutputDebugStringA(("ScrobblerConfig: " + std::string(e.what()) + "\n").c_str());
+    }
+
+    return std::nullopt;
+}
+
+Scrobbler::Scrobbler(ScrobblerConfig config, std::wstring journalPath)
+    : m_config(std::move(config)), m_journalPath(std::move(journalPath)), m_parkedPath(m_journalPath + L".parked") {
+}
+
+Scrobbler::~Scrobbler() {
+    Stop();
+}
+
+bool Scrobbler::IsScrobbleable(const PlayRecord& play) {
+    if (play.duration <= std::chrono::seconds(30)) return false;
+    return play.played >= (std::min)(play.duration / 2, std::chrono::seconds(std::chrono::minutes(4)));
+}
+
+ScrobblerStats Scrobbler::Stats() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void Scrobbler::Start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_thread.joinable()) return;
+
+    m_stopping = false;
+    m_cancellation.Reset();
+    m_stats = {};
+    LoadJournal();
+
+    m_thread = std::thread([this] {
+        winrt::init_apartment(winrt::apartment_type::multi_threaded);
+        Run();
+        winrt::uninit_apartment();
+        });
+}
+
+void Scrobbler::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_one();
+    m_cancellation.Cancel();
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    // Whatever is left stays in the journal for the next run
+    if (m_journal != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_journal);
+        m_journal = INVALID_HANDLE_VALUE;
+    }
+}
+
+void Scrobbler::Submit(const PlayRecord& play) {
+    if (!IsScrobbleable(play)) return;
+
+    nlohmann::json entry = {
+        {"artist", WideToUTF8(play.artist)},
+        {"album", WideToUTF8(play.albumTitle)},
+        {"track", WideToUTF8(play.title)},
+        {"timestamp", std::chrono::duration_cast<std::chrono::seconds>(play.startedAt.time_since_epoch()).count()},
+        {"duration", play.duration.count()},
+        {"played", play.played.count()}
+    };
+    std::string line = entry.dump();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Persist before queueing so the play survives a crash or an offline restart
+        if (!AppendToJournal(line)) {
+            OutputDebugStringA("Scrobbler: failed to journal play.\n");
+        }
+        m_pending.emplace_back(std::move(line), std::chrono::steady_clock::now());
+    }
+    m_cv.notify_one();
+}
+
+bool Scrobbler::LoadJournal() {
+    // Parked batches are older than anything still journaled, so they go first
+    for (const std::wstring* path : { &m_parkedPath, &m_journalPath }) {
+        std::ifstream in(*path, std::ios::binary);
+        std::string line;
+        while (in && std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+
+            // A torn last line from a crash fails to parse and is dropped
+            if (line.empty() || !nlohmann::json::accept(line)) continue;
+
+            // Plays carried over from a previous run are due immediately
+            m_pending.emplace_back(line, std::chrono::steady_clock::time_point{});
+        }
+    }
+
+    // The parked plays now live in the journal; only drop their file once that is on disk
+    if (!RewriteJournal()) return false;
+    DeleteFileW(m_parkedPath.c_str());
+    return true;
+}
+
+bool Scrobbler::AppendToJournal(const std::string& line) {
+    if (m_journal == INVALID_HANDLE_VALUE) {
+        m_journal = CreateFileW(m_journalPath.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, nullptr,
+            OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_journal == INVALID_HANDLE_VALUE) return false;
+    }
+
+    std::string record = line + "\n";
+    DWORD written = 0;
+    if (!WriteFile(m_journal, record.data(), static_cast<DWORD>(record.size()), &written, nullptr) || written != record.size()) {
+        return false;
+    }
+    return FlushFileBuffers(m_journal) != FALSE;
+}
+
+bool Scrobbler::ParkBatch(size_t count) {
+    HANDLE parked = CreateFileW(m_parkedPath.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, nullptr,
+        OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (parked == INVALID_HANDLE_VALUE) return false;
+
+    std::string records;
+    for (size_t i = 0; i < count; ++i) {
+        records += m_pending[i].first;
+        records += '\n';
+    }
+
+    DWORD written = 0;
+    bool durable = WriteFile(parked, records.data(), static_cast<DWORD>(records.size()), &written, nullptr)
+        && written == records.size()
+        && FlushFileBuffers(parked);
+    CloseHandle(parked);
+    return durable;
+}
+
+bool Scrobbler::RewriteJournal() {
+    if (m_journal != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_journal);
+        m_journal = INVALID_HANDLE_VALUE;
+    }
+
+    std::wstring tempPath = m_journalPath + L".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        for (const auto& [line, queuedAt] : m_pending) {
+            out << line << '\n';
+        }
+        if (!out.good()) return false;
+    }
+
+    if (!MoveFileExW(tempPath.c_str(), m_journalPath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        DeleteFileW(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+void Scrobbler::Run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (!m_stopping) {
+        auto now = std::chrono::steady_clock::now();
+
+        if (m_pending.empty()) {
+            m_cv.wait(lock, [this] { return m_stopping || !m_pending.empty(); });
+            continue;
+        }
+
+        auto batchDueAt = (m_pending.size() >= m_config.batchSize)
+            ? now
+            : m_pending.front().second + m_config.maxDelay;
+        auto sendAt = (std::max)(batchDueAt, m_retryAt);
+
+        if (now < sendAt) {
+            m_cv.wait_until(lock, sendAt);
+            continue;
+        }
+
+        size_t count = (std::min)(m_pending.size(), m_config.batchSize);
+        std::string body = "{\"scrobbles\":[";
+        for (size_t i = 0; i < count; ++i) {
+            if (i > 0) body += ',';
+            body += m_pending[i].first;
+        }
+        body += "]}";
+
+        auto oldestQueuedAt = m_pending.front().second;
+
+        lock.unlock();
+        auto requestStart = std::chrono::steady_clock::now();
+        int status = SyncWait(HttpPostJsonAsync(m_config.endpoint, std::move(body), m_config.authorization, &m_cancellation));
+        auto requestEnd = std::chrono::steady_clock::now();
+        lock.lock();
+
+        // Cancelled by Stop; the batch is still journaled, so it goes out on the next run
+        if (m_stopping) break;
+
+        ++m_stats.requests;
+
+        // Retrying cannot fix refused credentials, so those batches are parked rather than backed off forever.
+        // If parking fails the batch stays queued and is retried like any other failure.
+        bool unauthorized = status == 401 || status == 403;
+        bool accepted = status >= 200 && status < 300;
+        bool rejected = status >= 400 && status < 500 && status != 408 && status != 429 && !unauthorized;
+        bool parked = unauthorized && ParkBatch(count);
+
+        if (accepted || rejected || parked) {
+            m_pending.erase(m_pending.begin(), m_pending.begin() + count);
+            RewriteJournal();
+            m_backoff = std::chrono::milliseconds(0);
+            m_retryAt = {};
+        }
+
+        if (accepted) {
+            m_stats.playsSubmitted += count;
+
+            auto requestMs = std::chrono::duration_cast<std::chrono::milliseconds>(requestEnd - requestStart);
+            auto flushLatency = (oldestQueuedAt == std::chrono::steady_clock::time_point{})
+                ? requestMs
+                : std::chrono::duration_cast<std::chrono::milliseconds>(requestEnd - oldestQueuedAt);
+            m_stats.lastFlushLatency = flushLatency;
+            m_stats.maxFlushLatency = (std::max)(m_stats.maxFlushLatency, flushLatency);
+
+            std::ostringstream metrics;
+            metrics << "Scrobbler: sent " << count << " plays in " << requestMs.count() << " ms (flush latency "
+                << flushLatency.count() << " ms, " << static_cast<double>(m_stats.requests) / m_stats.playsSubmitted << " requests/play)\n";
+            OutputDebugStringA(metrics.str().c_str());
+        }
+        else if (rejected) {
+            OutputDebugStringA(("Scrobbler: endpoint rejected batch with HTTP " + std::to_string(status) + ", dropping it.\n").c_str());
+        }
+        else if (parked) {
+            m_stats.playsParked += count;
+            OutputDebugStringA(("Scrobbler: endpoint refused the credentials (HTTP " + std::to_string(status) + "), parked "
+                + std::to_string(count) + " plays until the next start.\n").c_str());
+        }
+        else {
+            m_backoff = (m_backoff.count() == 0) ? m_config.minBackoff : (std::min)(m_backoff * 2, m_config.maxBackoff);
+            m_retryAt = std::chrono::steady_clock::now() + m_backoff;
+
+            OutputDebugStringA(("Scrobbler: submission failed (HTTP " + std::to_string(status) + "), keeping "
+                + std::to_string(m_pending.size()) + " plays and retrying in " + std::to_string(m_backoff.count()) + " ms.\n").c_str());
+        }
+    }
+}
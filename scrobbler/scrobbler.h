@@ -0,0 +1,93 @@
+#pragma once
+
+#include <windows.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "../http/http-client.h"
+#include "../player/play-tracker.h"
+
+struct ScrobblerConfig {
+    std::wstring endpoint;
+    std::wstring authorization;
+
+    size_t batchSize = 50;
+
+    // A partial batch is sent once its oldest play has waited this long
+    std::chrono::milliseconds maxDelay{ std::chrono::minutes(5) };
+
+    // Wait after a failed submission, doubled per consecutive failure up to maxBackoff
+    std::chrono::milliseconds minBackoff{ std::chrono::seconds(30) };
+    std::chrono::milliseconds maxBackoff{ std::chrono::minutes(30) };
+
+    // Reads scrobbler.json; scrobbling stays disabled when the file or endpoint is missing
+    static std::optional<ScrobblerConfig> Load(const std::wstring& path);
+};
+
+// Submission counters since Start
+struct ScrobblerStats {
+    uint64_t requests = 0;      // Completed POSTs, whatever their status
+    uint64_t playsSubmitted = 0;
+    uint64_t playsParked = 0;
+    // From the oldest play in an accepted batch being queued to the endpoint accepting it
+    std::chrono::milliseconds lastFlushLatency{};
+    std::chrono::milliseconds maxFlushLatency{};
+};
+
+// Queues finished plays in an on-disk journal and submits them to the configured
+// endpoint in bounded batches, retrying with exponential backoff while offline.
+// A batch refused for its credentials (401/403) is not retried: it is parked in
+// <journal>.parked and requeued by the next Start, so fixing scrobbler.json and
+// restarting resubmits it.
+class Scrobbler {
+public:
+    Scrobbler(ScrobblerConfig config, std::wstring journalPath);
+    ~Scrobbler();
+
+    Scrobbler(const Scrobbler&) = delete;
+    Scrobbler& operator=(const Scrobbler&) = delete;
+
+    void Start();
+    void Stop();
+
+    void Submit(const PlayRecord& play);
+
+    // Mirrors the usual scrobbling rule: tracks over 30 s, listened to for half their length or 4 minutes
+    static bool IsScrobbleable(const PlayRecord& play);
+
+    ScrobblerStats Stats();
+
+private:
+    ScrobblerConfig m_config;
+    std::wstring m_journalPath;
+    std::wstring m_parkedPath;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stopping = false;
+    std::thread m_thread;
+
+    // Stop aborts a submission in flight instead of waiting for the endpoint
+    HttpCancellation m_cancellation;
+
+    // Serialized plays in journal order, each with the time it was queued
+    std::deque<std::pair<std::string, std::chrono::steady_clock::time_point>> m_pending;
+    HANDLE m_journal = INVALID_HANDLE_VALUE;
+
+    std::chrono::milliseconds m_backoff{ 0 };
+    std::chrono::steady_clock::time_point m_retryAt{};
+
+    ScrobblerStats m_stats;
+
+    void Run();
+    bool LoadJournal();
+    bool AppendToJournal(const std::string& line);
+    bool RewriteJournal();
+    bool ParkBatch(size_t count);
+};
@@ -0,0 +1,25 @@
+#include "app-data.h"
+
+#include <windows.h>
+#include <shlobj.h>
+
+#pragma comment(lib, "shell32.lib")
+#pragma comment(lib, "ole32.lib")
+
+std::wstring GetAppDataPath(const std::wstring& fileName) {
+    std::wstring directory;
+
+    PWSTR localAppData = nullptr;
+    if (SUCCEEDED(SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr, &localAppData))) {
+        directory = std::wstring(localAppData) + L"\\AppleMusicRichPresence";
+    }
+    else {
+        OutputDebugStringA("GetAppDataPath: LocalAppData not available, using working directory.\n");
+        directory = L".";
+    }
+    CoTaskMemFree(localAppData);
+
+    CreateDirectoryW(directory.c_str(), nullptr);
+
+    return directory + L"\\" + fileName;
+}
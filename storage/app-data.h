@@ -0,0 +1,6 @@
+#pragma once
+
+#include <string>
+
+// Returns %LOCALAPPDATA%\AppleMusicRichPresence\<fileName>, creating the directory if needed.
+std::wstring GetAppDataPath(const std::wstring& fileName);
@@ -0,0 +1,102 @@
+#include "presence-snapshot.h"
+
+#include <windows.h>
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+
+#include "../strings/string-utils.h"
+
+static constexpr int SnapshotVersion = 1;
+
+// A paused presence is only trusted for this long; a playing one until its track would have ended
+static constexpr std::chrono::minutes MaxPausedAge{ 30 };
+
+static int64_t ToMs(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+static std::chrono::system_clock::time_point FromMs(int64_t ms) {
+    return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::milliseconds(ms)));
+}
+
+bool SavePresenceSnapshot(const std::wstring& path, const PlayerInfo& info) {
+    nlohmann::json snapshot = {
+        {"version", SnapshotVersion},
+        {"savedAt", ToMs(std::chrono::system_clock::now())},
+        {"title", WideToUTF8(info.title)},
+        {"artist", WideToUTF8(info.artist)},
+        {"album", WideToUTF8(info.albumTitle)},
+        {"status", static_cast<int32_t>(info.playbackStatus)},
+        {"duration", info.duration.count()},
+        {"position", info.position.count()},
+        {"startTime", ToMs(info.startTime)}
+    };
+    if (info.thumbnailUrl) snapshot["thumbnailUrl"] = *info.thumbnailUrl;
+    if (info.albumUrl) snapshot["albumUrl"] = *info.albumUrl;
+
+    std::wstring tempPath = path + L".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out << snapshot.dump();
+        if (!out.good()) return false;
+    }
+
+    if (!MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        DeleteFileW(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::optional<PlayerInfo> LoadPresenceSnapshot(const std::wstring& path) {
+    using PlaybackStatus = GlobalSystemMediaTransportControlsSessionPlaybackStatus;
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return std::nullopt;
+
+    try {
+        auto snapshot = nlohmann::json::parse(in);
+        if (snapshot.value("version", 0) != SnapshotVersion) return std::nullopt;
+
+        PlayerInfo info;
+        info.title = UTF8ToWide(snapshot.value("title", ""));
+        info.artist = UTF8ToWide(snapshot.value("artist", ""));
+        info.albumTitle = UTF8ToWide(snapshot.value("album", ""));
+        info.playbackStatus = static_cast<PlaybackStatus>(snapshot.value("status", 0));
+        info.duration = std::chrono::seconds(snapshot.value("duration", int64_t(0)));
+        info.position = std::chrono::seconds(snapshot.value("position", int64_t(0)));
+        info.startTime = FromMs(snapshot.value("startTime", int64_t(0)));
+        if (snapshot.contains("thumbnailUrl")) info.thumbnailUrl = snapshot["thumbnailUrl"].get<std::string>();
+        if (snapshot.contains("albumUrl")) info.albumUrl = snapshot["albumUrl"].get<std::string>();
+
+        if (!info.isValid()) return std::nullopt;
+
+        auto now = std::chrono::system_clock::now();
+        if (info.playbackStatus == PlaybackStatus::Playing) {
+            if (info.startTime.time_since_epoch().count() == 0 || now >= info.startTime + info.duration) return std::nullopt;
+        }
+        else if (now - FromMs(snapshot.value("savedAt", int64_t(0))) > MaxPausedAge) {
+            return std::nullopt;
+        }
+
+        return info;
+    }
+    catch (const std::exception& e) {
+        OutputDebugStringA(("LoadPresenceSnapshot: " + std::string(e.what()) + "\n").c_str());
+    }
+
+    return std::nullopt;
+}
+
+bool PresenceDiffers(const PlayerInfo& a, const PlayerInfo& b) {
+    return a.title != b.title ||
+        a.artist != b.artist ||
+        a.albumTitle != b.albumTitle ||
+        a.playbackStatus != b.playbackStatus ||
+        a.duration != b.duration ||
+        a.startTime != b.startTime ||
+        a.thumbnailUrl != b.thumbnailUrl ||
+        a.albumUrl != b.albumUrl;
+}
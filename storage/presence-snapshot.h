@@ -0,0 +1,15 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+#include "../player/player-types.h"
+
+// Last published presence, kept on disk so a restart can show it before SMTC and the network answer.
+// Saved atomically (temp file + rename); Load returns nothing when the file is missing, torn or stale.
+bool SavePresenceSnapshot(const std::wstring& path, const PlayerInfo& info);
+std::optional<PlayerInfo> LoadPresenceSnapshot(const std::wstring& path);
+
+// True when the fields shown in Discord differ, i.e. the snapshot would need rewriting
+bool PresenceDiffers(const PlayerInfo& a, const PlayerInfo& b);
@@ -0,0 +1,62 @@
+#include "string-utils.h"
+
+#include <windows.h>
+
+std::string WideToUTF8(std::wstring_view wide) {
+    std::string utf8;
+    if (wide.empty()) return utf8;
+
+    int utf8Size = WideCharToMultiByte(CP_UTF8, 0, wide.data(), static_cast<int>(wide.size()), nullptr, 0, nullptr, nullptr);
+    if (utf8Size <= 0) return utf8;
+
+    utf8.resize(utf8Size);
+    WideCharToMultiByte(CP_UTF8, 0, wide.data(), static_cast<int>(wide.size()), &utf8[0], utf8Size, nullptr, nullptr);
+
+    return utf8;
+}
+
+void WideToUTF8(std::wstring_view wide, std::pmr::string& out) {
+    out.clear();
+    if (wide.empty()) return;
+
+    int utf8Size = WideCharToMultiByte(CP_UTF8, 0, wide.data(), static_cast<int>(wide.size()), nullptr, 0, nullptr, nullptr);
+    if (utf8Size <= 0) return;
+
+    out.resize(utf8Size);
+    WideCharToMultiByte(CP_UTF8, 0, wide.data(), static_cast<int>(wide.size()), &out[0], utf8Size, nullptr, nullptr);
+}
+
+std::wstring UTF8ToWide(std::string_view utf8) {
+    std::wstring wide;
+    if (utf8.empty()) return wide;
+
+    int wideSize = MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), nullptr, 0);
+    if (wideSize <= 0) return wide;
+
+    wide.resize(wideSize);
+    MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), &wide[0], wideSize);
+
+    return wide;
+}
+
+std::string UrlEncode(std::string_view value) {
+    static const char hex[] = "0123456789ABCDEF";
+
+    std::string escaped;
+    escaped.reserve(value.size() * 3);
+
+    for (unsigned char c : value) {
+        if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            escaped += static_cast<char>(c);
+        }
+        else if (c == ' ') {
+            escaped += '+';
+        }
+        else {
+            escaped += '%';
+            escaped += hex[c >> 4];
+            escaped += hex[c & 0x0F];
+        }
+    }
+    return escaped;
+}
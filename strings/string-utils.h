@@ -0,0 +1,16 @@
+#pragma once
+
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+// UTF-16 <-> UTF-8 conversions and URL encoding shared by every component.
+std::string WideToUTF8(std::wstring_view wide);
+
+// Converts into out, reusing its buffer and memory resource
+void WideToUTF8(std::wstring_view wide, std::pmr::string& out);
+
+std::wstring UTF8ToWide(std::string_view utf8);
+
+// Percent-encodes value for a query string, spaces as '+'
+std::string UrlEncode(std::string_view value);
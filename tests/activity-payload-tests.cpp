@@ -0,0 +1,60 @@
+#include "test-harness.h"
+
+#include "../memory/alloc-counter.h"
+#include "../presence/activity-payload.h"
+
+#include <memory_resource>
+
+#ifndef AMRP_ALLOCATION_COUNTING
+#error "The test project must define AMRP_COUNT_ALLOCATIONS so heap allocations can be counted"
+#endif
+
+static PlayerInfo SampleTrack() {
+    PlayerInfo info;
+    info.title = L"Strobe (Club Edit) - a title long enough to leave the small-string buffer";
+    info.artist = L"deadmau5";
+    info.albumTitle = L"For Lack of a Better Name";
+    info.duration = std::chrono::seconds(637);
+    info.position = std::chrono::seconds(42);
+    info.playbackStatus = GlobalSystemMediaTransportControlsSessionPlaybackStatus::Playing;
+    info.thumbnailUrl = "https://is1-ssl.mzstatic.com/image/thumb/Music/v4/100x100bb.jpg";
+    info.albumUrl = "https://music.apple.com/us/album/for-lack-of-a-better-name/1";
+    return info;
+}
+
+// Guards the test below against passing vacuously because the counter isn't hooked up
+TEST(AllocationCounterSeesGlobalNew) {
+    AllocationAudit audit;
+    int* volatile value = new int(1); // volatile so the pair can't be elided
+    delete value;
+    CHECK(audit.Allocations() == 1);
+}
+
+// Same shape as PublishAsync: a fixed buffer reset per update. The upstream is the null resource, so
+// outgrowing the buffer throws instead of silently falling back to the heap.
+TEST(ActivityPayloadDoesNotTouchTheHeap) {
+    PlayerInfo info = SampleTrack();
+    PresenceTemplates templates = PresenceTemplates::Defaults();
+
+    static std::byte buffer[16 * 1024];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+
+    for (int update = 0; update < 4; ++update) {
+        arena.release();
+
+        AllocationAudit audit;
+        bool overflowed = false;
+        try {
+            std::pmr::string activity(&arena);
+            BuildActivityPayload(info, templates, activity);
+            CHECK(activity.find("\"details\"") != std::pmr::string::npos);
+            CHECK(activity.find("\"timestamps\"") != std::pmr::string::npos);
+        }
+        catch (const std::bad_alloc&) {
+            overflowed = true;
+        }
+
+        CHECK(!overflowed);
+        CHECK(audit.Allocations() == 0);
+    }
+}
@@ -0,0 +1,98 @@
+#include "test-harness.h"
+
+#include "../scheduler/adaptive-scheduler.h"
+
+using namespace std::chrono_literals;
+
+// Drives the scheduler the way the Init loop does, on a simulated clock with no events: one pass at the start,
+// then one pass per deadline, for one minute. Returns the wakeups that minute cost.
+static size_t WakeupsPerMinute(SchedulerInputs inputs, bool discordAnswers = false) {
+    auto start = AdaptiveScheduler::Clock::time_point{} + 1h;
+    auto end = start + 1min;
+
+    AdaptiveScheduler scheduler(start);
+    auto now = start;
+
+    for (;;) {
+        auto actions = scheduler.Wake(inputs, now);
+        if (actions.connectDiscord && discordAnswers) {
+            inputs.discordConnected = true;
+        }
+
+        auto deadline = scheduler.NextDeadline(inputs);
+        if (!deadline || *deadline >= end) break;
+        now = *deadline;
+    }
+
+    auto period = scheduler.Finish(end);
+    CHECK(period.elapsed == 1min);
+    return period.wakeups;
+}
+
+TEST(SchedulerNoSessionSleepsUntilAnEvent) {
+    CHECK(WakeupsPerMinute({}) == 0);
+}
+
+TEST(SchedulerIdleSleepsUntilAnEvent) {
+    SchedulerInputs inputs;
+    inputs.attached = true;
+    inputs.discordConnected = true;
+    CHECK(WakeupsPerMinute(inputs) == 0);
+
+    // A paused session with Discord closed still gets no retry timer
+    inputs.discordConnected = false;
+    inputs.needsTimelineSample = true;
+    CHECK(WakeupsPerMinute(inputs) == 0);
+}
+
+TEST(SchedulerPlayingWakesOnlyForOutstandingWork) {
+    SchedulerInputs inputs;
+    inputs.attached = true;
+    inputs.playing = true;
+    inputs.discordConnected = true;
+    CHECK(WakeupsPerMinute(inputs) == 0);
+
+    // Connecting on the first pass leaves nothing to retry
+    inputs.discordConnected = false;
+    CHECK(WakeupsPerMinute(inputs, true) == 0);
+
+    // Discord unreachable: one attempt every DiscordRetry, at 5 s through 55 s
+    CHECK(WakeupsPerMinute(inputs) == 11);
+
+    // No duration reported yet: polls back off at 1, 3, 7, 15 and 31 s; the next would be at 63 s
+    inputs.discordConnected = true;
+    inputs.needsTimelineSample = true;
+    CHECK(WakeupsPerMinute(inputs) == 5);
+}
+
+TEST(SchedulerReportsThePeriodEachStateLasted) {
+    auto t0 = AdaptiveScheduler::Clock::time_point{} + 1h;
+    AdaptiveScheduler scheduler(t0);
+
+    SchedulerInputs playing;
+    playing.attached = true;
+    playing.playing = true;
+
+    auto first = scheduler.Wake(playing, t0);
+    CHECK(first.connectDiscord);
+    CHECK(first.finished && first.finished->state == SchedulerState::NoSession && first.finished->wakeups == 0);
+
+    CHECK(!scheduler.Wake(playing, t0 + 5s).finished);
+    CHECK(!scheduler.Wake(playing, t0 + 10s).finished);
+
+    SchedulerInputs paused = playing;
+    paused.playing = false;
+    auto left = scheduler.Wake(paused, t0 + 12s);
+    CHECK(left.finished && left.finished->state == SchedulerState::Playing);
+    // The wait that ended here was spent playing, so it counts there
+    CHECK(left.finished && left.finished->wakeups == 3 && left.finished->elapsed == 12s);
+    CHECK(scheduler.State() == SchedulerState::Idle);
+    CHECK(!scheduler.NextDeadline(paused));
+
+    // Resuming retries Discord straight away instead of waiting out the old timer
+    auto resumed = scheduler.Wake(playing, t0 + 13s);
+    CHECK(resumed.connectDiscord);
+
+    auto last = scheduler.Finish(t0 + 20s);
+    CHECK(last.state == SchedulerState::Playing && last.wakeups == 0 && last.elapsed == 7s);
+}
@@ -0,0 +1,172 @@
+#include "test-harness.h"
+
+#include "../async/executor.h"
+#include "../async/task.h"
+#include "../memory/update-arena.h"
+#include "../presence/activity-payload.h"
+
+#include <Windows.h>
+#include <winternl.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Context-switch count of every live thread in this process, keyed by thread id
+static std::unordered_map<DWORD, ULONG> TakeThreadCensus() {
+    constexpr NTSTATUS InfoLengthMismatch = static_cast<NTSTATUS>(0xC0000004L);
+
+    std::unordered_map<DWORD, ULONG> census;
+
+    std::vector<std::byte> buffer(1 << 20);
+    ULONG needed = 0;
+    NTSTATUS status;
+    while ((status = NtQuerySystemInformation(SystemProcessInformation, buffer.data(), static_cast<ULONG>(buffer.size()), &needed)) == InfoLengthMismatch) {
+        buffer.resize(needed + 64 * 1024);
+    }
+    if (status < 0) return census;
+
+    HANDLE self = ULongToHandle(GetCurrentProcessId());
+    auto process = reinterpret_cast<const SYSTEM_PROCESS_INFORMATION*>(buffer.data());
+    while (true) {
+        if (process->UniqueProcessId == self) {
+            // Thread entries follow the process entry; Reserved3 is the thread's context-switch count
+            auto threads = reinterpret_cast<const SYSTEM_THREAD_INFORMATION*>(process + 1);
+            for (ULONG i = 0; i < process->NumberOfThreads; ++i) {
+                census[HandleToULong(threads[i].ClientId.UniqueThread)] = threads[i].Reserved3;
+            }
+            break;
+        }
+        if (process->NextEntryOffset == 0) break;
+        process = reinterpret_cast<const SYSTEM_PROCESS_INFORMATION*>(reinterpret_cast<const std::byte*>(process) + process->NextEntryOffset);
+    }
+    return census;
+}
+
+// Prints threads created and context switches between two censuses, per update
+static void ReportPerUpdate(const char* label, size_t updates, std::chrono::steady_clock::duration elapsed,
+    const std::unordered_map<DWORD, ULONG>& before, const std::unordered_map<DWORD, ULONG>& after) {
+    size_t created = 0;
+    uint64_t switches = 0;
+    for (const auto& [id, count] : after) {
+        auto previous = before.find(id);
+        if (previous == before.end()) {
+            ++created;
+            switches += count;
+        }
+        else {
+            switches += count - previous->second;
+        }
+    }
+
+    double microseconds = std::chrono::duration<double, std::micro>(elapsed).count() / static_cast<double>(updates);
+    std::printf("  %-28s %6.2f threads %8.2f switches %8.1f us  per update\n", label,
+        static_cast<double>(created) / static_cast<double>(updates),
+        static_cast<double>(switches) / static_cast<double>(updates),
+        microseconds);
+}
+
+static PlayerInfo SampleTrack() {
+    PlayerInfo info;
+    info.title = L"Teardrop";
+    info.artist = L"Massive Attack";
+    info.albumTitle = L"Mezzanine";
+    info.duration = std::chrono::seconds(330);
+    info.position = std::chrono::seconds(12);
+    info.playbackStatus = GlobalSystemMediaTransportControlsSessionPlaybackStatus::Playing;
+    info.albumUrl = "https://music.apple.com/us/album/mezzanine/1";
+    return info;
+}
+
+// Stands in for an SMTC or HTTP operation: it completes on another thread, as WinRT completions do
+static Task<void> LookupAsync(Executor& io) {
+    co_await io.Schedule();
+}
+
+static void BuildPayload(const PlayerInfo& info, const PresenceTemplates& templates, UpdateArena& arena) {
+    arena.Reset();
+    std::pmr::string activity(arena.Resource());
+    BuildActivityPayload(info, templates, activity);
+}
+
+// PublishAsync's shape: hop onto the IPC executor, suspend on the artwork lookup, hop back and build the payload
+static Task<void> PublishShapedAsync(Executor& ipc, Executor& io, const PlayerInfo& info, const PresenceTemplates& templates, UpdateArena& arena) {
+    co_await ipc.Schedule();
+    co_await LookupAsync(io);
+    co_await ipc.Schedule();
+    BuildPayload(info, templates, arena);
+}
+
+// Counts detached threads through finishing their update, then holds them until the census has seen them
+struct DetachedThreadGate {
+    std::mutex mutex;
+    std::condition_variable progress; // Only the benchmark waits here
+    std::condition_variable release;  // Only parked threads wait here, so they wake once
+    size_t finished = 0;
+    size_t exited = 0;
+    bool released = false;
+};
+
+// Threads and context switches per update for the coroutine pipeline against the thread-per-update path it
+// replaced, where each update blocked its own thread on the lookup as .get() did
+BENCHMARK(ExecutorVersusDetachedThreads) {
+    constexpr size_t Updates = 500;
+
+    PlayerInfo info = SampleTrack();
+    PresenceTemplates templates = PresenceTemplates::Defaults();
+    UpdateArena arena;
+
+    // Both executors start before the first census, as the IPC executor is created once in Init
+    Executor ipc;
+    Executor io;
+    SyncWait(PublishShapedAsync(ipc, io, info, templates, arena));
+
+    {
+        auto before = TakeThreadCensus();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < Updates; ++i) {
+            SyncWait(PublishShapedAsync(ipc, io, info, templates, arena));
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        ReportPerUpdate("executor", Updates, elapsed, before, TakeThreadCensus());
+    }
+
+    {
+        // Parked threads are still live at the second census, so their switch counts are included; parking adds
+        // at most one switch per thread
+        DetachedThreadGate gate;
+
+        auto before = TakeThreadCensus();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < Updates; ++i) {
+            std::thread([&] {
+                SyncWait(LookupAsync(io));
+                BuildPayload(info, templates, arena);
+
+                std::unique_lock<std::mutex> lock(gate.mutex);
+                ++gate.finished;
+                gate.progress.notify_one();
+                gate.release.wait(lock, [&] { return gate.released; });
+                ++gate.exited;
+                gate.progress.notify_one();
+            }).detach();
+
+            // One update at a time, as on the executor, so the arena is never shared
+            std::unique_lock<std::mutex> lock(gate.mutex);
+            gate.progress.wait(lock, [&] { return gate.finished == i + 1; });
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        ReportPerUpdate("detached thread per update", Updates, elapsed, before, TakeThreadCensus());
+
+        std::unique_lock<std::mutex> lock(gate.mutex);
+        gate.released = true;
+        gate.release.notify_all();
+        gate.progress.wait(lock, [&] { return gate.exited == Updates; });
+    }
+
+    ipc.Stop();
+    io.Stop();
+}
@@ -0,0 +1,211 @@
+#include "test-harness.h"
+
+#include "../history/listening-history.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// A history directory of its own per test, removed afterwards
+class ScratchHistory {
+public:
+    explicit ScratchHistory(const wchar_t* name)
+        : m_path(std::filesystem::temp_directory_path() / (std::wstring(L"amrp-history-") + name + L"-" + std::to_wstring(GetCurrentProcessId()))) {
+        std::error_code ignored;
+        std::filesystem::remove_all(m_path, ignored);
+    }
+
+    ~ScratchHistory() {
+        std::error_code ignored;
+        std::filesystem::remove_all(m_path, ignored);
+    }
+
+    const std::filesystem::path& Path() const { return m_path; }
+
+private:
+    std::filesystem::path m_path;
+};
+
+static ListeningHistory::TimePoint At(std::chrono::hours offset) {
+    // Somewhere in 2024, well clear of the zero timestamp that marks an empty slot
+    return ListeningHistory::TimePoint(std::chrono::hours(475000) + offset);
+}
+
+static PlayRecord Play(const wchar_t* artist, const wchar_t* title, ListeningHistory::TimePoint startedAt, int playedSeconds = 200) {
+    PlayRecord play;
+    play.artist = artist;
+    play.title = title;
+    play.albumTitle = std::wstring(artist) + L" - Album";
+    play.startedAt = startedAt;
+    play.played = std::chrono::seconds(playedSeconds);
+    play.duration = std::chrono::seconds(240);
+    return play;
+}
+
+static std::vector<HistoryRecord> AllRecords(ListeningHistory& history) {
+    std::vector<HistoryRecord> records;
+    history.ForEach(ListeningHistory::TimePoint::min(), ListeningHistory::TimePoint::max(),
+        [&](const HistoryRecord& record) { records.push_back(record); });
+    return records;
+}
+
+static uint64_t Ms(ListeningHistory::TimePoint time) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count());
+}
+
+TEST(HistoryReopenKeepsRecordsAndStrings) {
+    ScratchHistory scratch(L"reopen");
+
+    {
+        ListeningHistory history;
+        CHECK(history.Open(scratch.Path().wstring()));
+        CHECK(history.Append(Play(L"Portishead", L"Roads", At(std::chrono::hours(0)))));
+        CHECK(history.Append(Play(L"Portishead", L"Glory Box", At(std::chrono::hours(1)))));
+        CHECK(history.Append(Play(L"Bj\u00f6rk", L"J\u00f3ga", At(std::chrono::hours(2)))));
+        history.Close();
+    }
+
+    ListeningHistory history;
+    CHECK(history.Open(scratch.Path().wstring()));
+
+    auto records = AllRecords(history);
+    CHECK(records.size() == 3);
+    if (records.size() != 3) return;
+
+    CHECK(records[0].artistId == records[1].artistId);
+    CHECK(history.Lookup(records[0].artistId) == L"Portishead");
+    CHECK(history.Lookup(records[1].titleId) == L"Glory Box");
+    CHECK(history.Lookup(records[2].artistId) == L"Bj\u00f6rk");
+    CHECK(history.Lookup(records[2].titleId) == L"J\u00f3ga");
+    CHECK(records[2].startedAtMs == Ms(At(std::chrono::hours(2))));
+    CHECK(records[2].playedSeconds == 200);
+    CHECK(records[2].durationSeconds == 240);
+
+    // Appends continue after the recovered records rather than over them
+    CHECK(history.Append(Play(L"Portishead", L"Sour Times", At(std::chrono::hours(3)))));
+    CHECK(AllRecords(history).size() == 4);
+}
+
+// After a power loss any page can be missing, not just the last one. Records past the first bad one are not
+// trusted even when their own checksum holds, must not come back once the hole is refilled, and the next
+// append takes the bad record's slot.
+TEST(HistoryRecoveryStopsAtFirstTornRecord) {
+    ScratchHistory scratch(L"torn");
+
+    {
+        ListeningHistory history;
+        CHECK(history.Open(scratch.Path().wstring()));
+        for (int i = 0; i < 5; ++i) {
+            CHECK(history.Append(Play(L"Massive Attack", L"Angel", At(std::chrono::hours(i)))));
+        }
+        history.Close();
+    }
+
+    {
+        // Tear record 1 by damaging its checksum; records 2-4 stay intact
+        std::fstream segment(scratch.Path() / L"history-000000.seg", std::ios::in | std::ios::out | std::ios::binary);
+        CHECK(segment.is_open());
+        std::streamoff offset = static_cast<std::streamoff>(sizeof(HistoryRecord) + offsetof(HistoryRecord, checksum));
+        segment.seekg(offset);
+        char byte = 0;
+        segment.read(&byte, 1);
+        byte = static_cast<char>(byte ^ 0xFF);
+        segment.seekp(offset);
+        segment.write(&byte, 1);
+    }
+
+    {
+        // A string table entry cut off mid-write: a length prefix promising more bytes than follow
+        std::ofstream strings(scratch.Path() / L"strings.dat", std::ios::binary | std::ios::app);
+        uint32_t length = 100;
+        strings.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        strings.write("Une", 3);
+    }
+
+    {
+        ListeningHistory history;
+        CHECK(history.Open(scratch.Path().wstring()));
+
+        auto records = AllRecords(history);
+        CHECK(records.size() == 1);
+        CHECK(!records.empty() && records[0].startedAtMs == Ms(At(std::chrono::hours(0))));
+
+        CHECK(history.Append(Play(L"Unerase", L"Moment", At(std::chrono::hours(9)))));
+        history.Close();
+    }
+
+    ListeningHistory history;
+    CHECK(history.Open(scratch.Path().wstring()));
+
+    auto records = AllRecords(history);
+    CHECK(records.size() == 2);
+    if (records.size() != 2) return;
+
+    CHECK(records[1].startedAtMs == Ms(At(std::chrono::hours(9))));
+    CHECK(history.Lookup(records[0].artistId) == L"Massive Attack");
+    CHECK(history.Lookup(records[1].artistId) == L"Unerase");
+    CHECK(history.Lookup(records[1].titleId) == L"Moment");
+}
+
+TEST(HistoryRangeQueriesSeekToTheWindow) {
+    ScratchHistory scratch(L"range");
+
+    ListeningHistory history;
+    CHECK(history.Open(scratch.Path().wstring()));
+    for (int i = 0; i < 6; ++i) {
+        CHECK(history.Append(Play(i % 2 ? L"Burial" : L"Four Tet", L"Track", At(std::chrono::hours(i)))));
+    }
+
+    std::vector<uint64_t> started;
+    history.ForEach(At(std::chrono::hours(2)), At(std::chrono::hours(5)),
+        [&](const HistoryRecord& record) { started.push_back(record.startedAtMs); });
+    CHECK(started.size() == 3);
+    CHECK(started.size() == 3
+        && started[0] == Ms(At(std::chrono::hours(2)))
+        && started[2] == Ms(At(std::chrono::hours(4))));
+
+    // Windows are half-open: a play starting exactly at the end is excluded
+    CHECK(history.PlaysForArtist(L"Four Tet", At(std::chrono::hours(0)), At(std::chrono::hours(6))) == 3);
+    CHECK(history.PlaysForArtist(L"Four Tet", At(std::chrono::hours(1)), At(std::chrono::hours(4))) == 1);
+    CHECK(history.PlaysForArtist(L"Burial", At(std::chrono::hours(1)), At(std::chrono::hours(5))) == 2);
+    CHECK(history.PlaysForArtist(L"Burial", At(std::chrono::hours(6)), At(std::chrono::hours(9))) == 0);
+    CHECK(history.PlaysForArtist(L"Nobody", At(std::chrono::hours(0)), At(std::chrono::hours(6))) == 0);
+}
+
+TEST(HistoryTopArtistsRanksByPlaysThenListeningTime) {
+    ScratchHistory scratch(L"top");
+
+    ListeningHistory history;
+    CHECK(history.Open(scratch.Path().wstring()));
+
+    int hour = 0;
+    auto add = [&](const wchar_t* artist, int playedSeconds) {
+        CHECK(history.Append(Play(artist, L"Track", At(std::chrono::hours(hour++)), playedSeconds)));
+    };
+    add(L"Aphex Twin", 100);
+    add(L"Boards of Canada", 300);
+    add(L"Aphex Twin", 100);
+    add(L"Autechre", 150);
+    add(L"Boards of Canada", 300);
+    add(L"Aphex Twin", 100);
+    add(L"Autechre", 150);
+    add(L"Plaid", 500);
+
+    auto top = history.TopArtists(At(std::chrono::hours(0)), At(std::chrono::hours(hour)), 3);
+    CHECK(top.size() == 3);
+    if (top.size() != 3) return;
+
+    CHECK(top[0].artist == L"Aphex Twin" && top[0].plays == 3 && top[0].played == std::chrono::seconds(300));
+    // Two plays each; more time listened ranks first
+    CHECK(top[1].artist == L"Boards of Canada" && top[1].plays == 2 && top[1].played == std::chrono::seconds(600));
+    CHECK(top[2].artist == L"Autechre" && top[2].plays == 2 && top[2].played == std::chrono::seconds(300));
+
+    CHECK(history.TopArtists(At(std::chrono::hours(0)), At(std::chrono::hours(hour)), 10).size() == 4);
+
+    // Only the window counts: the last three plays
+    auto recent = history.TopArtists(At(std::chrono::hours(5)), At(std::chrono::hours(hour)), 1);
+    CHECK(recent.size() == 1 && recent[0].artist == L"Plaid" && recent[0].plays == 1);
+}
@@ -0,0 +1,196 @@
+#include "test-harness.h"
+
+#include "../feed/now-playing-feed.h"
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// now-playing-reader.c: the C header's reader, built as C
+extern "C" {
+    const amrp_feed* test_feed_open(const wchar_t* name, HANDLE* mapping);
+    int test_feed_read(const amrp_feed* feed, amrp_now_playing* out);
+    void test_feed_close(const amrp_feed* feed, HANDLE mapping);
+}
+
+// A private mapping, so a running app's feed is never touched
+static std::wstring TestFeedName() {
+    return std::wstring(AMRP_FEED_NAME) + L".Test." + std::to_wstring(GetCurrentProcessId());
+}
+
+// Every field is derived from one counter, so a snapshot that mixes two writes is detectable
+static std::string FieldText(const char* field, uint64_t n) {
+    std::string text = std::string(field) + "-" + std::to_string(n) + "-";
+    text.append(300, static_cast<char>('a' + n % 26));
+    return text;
+}
+
+static PlayerInfo TrackFor(uint64_t n) {
+    auto widen = [](const std::string& text) { return std::wstring(text.begin(), text.end()); };
+
+    PlayerInfo info;
+    info.title = widen(FieldText("title", n));
+    info.artist = widen(FieldText("artist", n));
+    info.albumTitle = widen(FieldText("album", n));
+    info.position = std::chrono::seconds(n);
+    info.duration = std::chrono::seconds(2 * n);
+    info.playbackStatus = (n % 2) ? GlobalSystemMediaTransportControlsSessionPlaybackStatus::Playing
+        : GlobalSystemMediaTransportControlsSessionPlaybackStatus::Paused;
+    info.thumbnailUrl = FieldText("artwork", n);
+    info.albumUrl = FieldText("url", n);
+    return info;
+}
+
+static bool IsConsistent(const amrp_now_playing& now, uint64_t& n) {
+    n = static_cast<uint64_t>(now.position_ms / 1000);
+    return now.duration_ms == 2 * now.position_ms
+        && now.status == ((n % 2) ? AMRP_STATUS_PLAYING : AMRP_STATUS_PAUSED)
+        && FieldText("title", n) == now.title
+        && FieldText("artist", n) == now.artist
+        && FieldText("album", n) == now.album
+        && FieldText("artwork", n) == now.artwork_url
+        && FieldText("url", n) == now.album_url;
+}
+
+// Readers hammer the seqlock while the writer publishes; every snapshot they accept must be one whole write,
+// and each reader must never see the counter go backwards
+TEST(NowPlayingFeedReadersNeverSeeTornWrites) {
+    constexpr int Readers = 8;
+    constexpr uint64_t Writes = 200000;
+
+    std::wstring name = TestFeedName();
+    NowPlayingFeed feed;
+    CHECK(feed.Open(name.c_str()));
+    feed.Publish(TrackFor(1), 1);
+
+    std::atomic<bool> writing = true;
+    std::atomic<int> opened = 0;
+    std::atomic<uint64_t> snapshots = 0;
+    std::atomic<uint64_t> torn = 0;
+    std::atomic<uint64_t> regressions = 0;
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < Readers; ++i) {
+        readers.emplace_back([&] {
+            HANDLE mapping = nullptr;
+            const amrp_feed* view = test_feed_open(name.c_str(), &mapping);
+            if (!view) return;
+            ++opened;
+
+            amrp_now_playing now;
+            uint64_t last = 0;
+            while (writing.load(std::memory_order_acquire)) {
+                // Giving up while the writer stays busy is allowed; returning a mixed snapshot is not
+                if (!test_feed_read(view, &now)) continue;
+
+                uint64_t n = 0;
+                if (!IsConsistent(now, n)) ++torn;
+                else if (n < last) ++regressions;
+                else last = n;
+                ++snapshots;
+            }
+
+            test_feed_close(view, mapping);
+        });
+    }
+
+    for (uint64_t n = 2; n <= Writes; ++n) {
+        feed.Publish(TrackFor(n), n);
+    }
+    writing.store(false, std::memory_order_release);
+
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    feed.Close();
+
+    std::printf("  %llu snapshots across %d readers\n", static_cast<unsigned long long>(snapshots.load()), Readers);
+    CHECK(opened == Readers);
+    CHECK(snapshots > 0);
+    CHECK(torn == 0);
+    CHECK(regressions == 0);
+}
+
+// Over-long text is cut at a character boundary, never inside a UTF-8 sequence or a surrogate pair
+TEST(NowPlayingFeedTruncatesAtCodePointBoundary) {
+    std::wstring name = TestFeedName();
+    NowPlayingFeed feed;
+    CHECK(feed.Open(name.c_str()));
+
+    PlayerInfo info = TrackFor(1);
+    info.title.clear();
+    for (int i = 0; i < 300; ++i) info.title += L"\u00e9"; // 2 bytes each
+    info.artist.clear();
+    for (int i = 0; i < 200; ++i) info.artist += L"\U0001F3B5"; // surrogate pair, 4 bytes each
+    feed.Publish(info, 1);
+
+    HANDLE mapping = nullptr;
+    const amrp_feed* view = test_feed_open(name.c_str(), &mapping);
+    CHECK(view != nullptr);
+
+    amrp_now_playing now{};
+    if (view && test_feed_read(view, &now)) {
+        CHECK(std::strlen(now.title) == 510);
+        for (size_t i = 0; i < 510; i += 2) {
+            CHECK(std::memcmp(now.title + i, "\xC3\xA9", 2) == 0);
+            if (std::memcmp(now.title + i, "\xC3\xA9", 2) != 0) break;
+        }
+
+        CHECK(std::strlen(now.artist) == 508);
+        for (size_t i = 0; i < 508; i += 4) {
+            CHECK(std::memcmp(now.artist + i, "\xF0\x9F\x8E\xB5", 4) == 0);
+            if (std::memcmp(now.artist + i, "\xF0\x9F\x8E\xB5", 4) != 0) break;
+        }
+    }
+    else {
+        CHECK(!"feed could not be read");
+    }
+
+    test_feed_close(view, mapping);
+    feed.Close();
+}
+
+// The drain publishes before the thumbnail is resolved; the artwork arrives as a republish of the same update,
+// which must land unless a newer update or a cleared session got there first
+TEST(NowPlayingFeedFillsInArtworkOnlyForTheLatestUpdate) {
+    std::wstring name = TestFeedName();
+    NowPlayingFeed feed;
+    CHECK(feed.Open(name.c_str()));
+
+    HANDLE mapping = nullptr;
+    const amrp_feed* view = test_feed_open(name.c_str(), &mapping);
+    CHECK(view != nullptr);
+
+    amrp_now_playing now{};
+    auto read = [&] { return view && test_feed_read(view, &now); };
+
+    PlayerInfo first = TrackFor(1);
+    first.thumbnailUrl.reset();
+    feed.Publish(first, 1);
+    CHECK(read() && now.artwork_url[0] == '\0' && FieldText("title", 1) == now.title);
+
+    first.thumbnailUrl = FieldText("artwork", 1);
+    feed.Publish(first, 1);
+    CHECK(read() && FieldText("artwork", 1) == now.artwork_url);
+
+    // A lookup for the previous track finishing late must not put its artwork on the next one
+    PlayerInfo second = TrackFor(2);
+    second.thumbnailUrl.reset();
+    feed.Publish(second, 2);
+    feed.Publish(first, 1);
+    CHECK(read() && FieldText("title", 2) == now.title && now.artwork_url[0] == '\0');
+
+    // Nor reopen a feed cleared while it was pending
+    feed.Clear();
+    second.thumbnailUrl = FieldText("artwork", 2);
+    feed.Publish(second, 2);
+    CHECK(read() && now.status == AMRP_STATUS_CLOSED && now.artwork_url[0] == '\0');
+
+    feed.Publish(TrackFor(3), 3);
+    CHECK(read() && FieldText("artwork", 3) == now.artwork_url);
+
+    test_feed_close(view, mapping);
+    feed.Close();
+}
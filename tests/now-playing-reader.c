@@ -0,0 +1,14 @@
+/* Compiled as C, so the tests exercise now-playing.h exactly as an overlay would include it */
+#include "../feed/now-playing.h"
+
+const amrp_feed* test_feed_open(const wchar_t* name, HANDLE* mapping) {
+    return amrp_feed_open_named(name, mapping);
+}
+
+int test_feed_read(const amrp_feed* feed, amrp_now_playing* out) {
+    return amrp_feed_read(feed, out);
+}
+
+void test_feed_close(const amrp_feed* feed, HANDLE mapping) {
+    amrp_feed_close(feed, mapping);
+}
@@ -0,0 +1,65 @@
+#include "test-harness.h"
+
+#include "../player/play-tracker.h"
+
+using namespace std::chrono_literals;
+
+static PlayerInfo Snapshot(const wchar_t* title, std::chrono::seconds position, bool playing = true) {
+    PlayerInfo info;
+    info.title = title;
+    info.artist = L"Daft Punk";
+    info.albumTitle = L"Discovery";
+    info.duration = 210s;
+    info.position = position;
+    info.playbackStatus = playing ? GlobalSystemMediaTransportControlsSessionPlaybackStatus::Playing
+        : GlobalSystemMediaTransportControlsSessionPlaybackStatus::Paused;
+    return info;
+}
+
+TEST(PlayTrackerFinishesPlayOnTrackChange) {
+    PlayTracker tracker;
+    auto t0 = PlayTracker::Clock::time_point{} + 1h;
+
+    CHECK(!tracker.Observe(Snapshot(L"One More Time", 0s), t0));
+    CHECK(!tracker.Observe(Snapshot(L"One More Time", 120s), t0 + 120s));
+
+    auto finished = tracker.Observe(Snapshot(L"Aerodynamic", 0s), t0 + 200s);
+    CHECK(finished && finished->title == L"One More Time" && finished->played == 200s);
+
+    // A skip is too short to count
+    CHECK(!tracker.Observe(Snapshot(L"Digital Love", 0s), t0 + 205s));
+}
+
+// Repeat-one keeps the same track; each wrap from the end back to the start is its own play, even when the
+// last observation was early in the track
+TEST(PlayTrackerCountsEachRepeatOfTheSameTrack) {
+    PlayTracker tracker;
+    auto t0 = PlayTracker::Clock::time_point{} + 1h;
+
+    CHECK(!tracker.Observe(Snapshot(L"Something About Us", 0s), t0));
+    CHECK(!tracker.Observe(Snapshot(L"Something About Us", 30s), t0 + 30s));
+
+    auto first = tracker.Observe(Snapshot(L"Something About Us", 1s), t0 + 211s);
+    CHECK(first && first->played == 211s);
+
+    auto second = tracker.Observe(Snapshot(L"Something About Us", 0s), t0 + 421s);
+    CHECK(second && second->played == 210s);
+
+    auto last = tracker.Finish(t0 + 500s);
+    CHECK(last && last->title == L"Something About Us" && last->played == 79s);
+}
+
+TEST(PlayTrackerTreatsSeeksToTheStartMidTrackAsTheSamePlay) {
+    PlayTracker tracker;
+    auto t0 = PlayTracker::Clock::time_point{} + 1h;
+
+    CHECK(!tracker.Observe(Snapshot(L"Veridis Quo", 0s), t0));
+
+    // Back to the start halfway through
+    CHECK(!tracker.Observe(Snapshot(L"Veridis Quo", 0s), t0 + 100s));
+
+    // Paused near the end, then restarted much later: the position, not the wall clock, says it had ended
+    CHECK(!tracker.Observe(Snapshot(L"Veridis Quo", 205s, false), t0 + 305s));
+    auto replay = tracker.Observe(Snapshot(L"Veridis Quo", 0s), t0 + 900s);
+    CHECK(replay && replay->played == 305s);
+}
@@ -0,0 +1,54 @@
+#include "test-harness.h"
+
+#include "../catalog/catalog-index.h"
+#include "../player/player.h"
+
+#include <filesystem>
+
+// Times the compile-time Refresh<Flags> against runtime-flag ForceUpdate for the same fields. Needs Apple Music
+// with a track in the media session; otherwise it only reports that it was skipped.
+BENCHMARK(RefreshVersusForceUpdate) {
+    auto player = std::make_shared<Player>();
+    player->Initialize();
+
+    {
+        std::unique_lock<std::mutex> lock(player->m_cvMutex);
+        player->m_cv.wait_for(lock, std::chrono::seconds(5), [&] { return player->isValidTrack(); });
+    }
+    if (!player->isValidTrack()) {
+        std::printf("  skipped: no Apple Music track in the media session\n");
+        return;
+    }
+
+    // Artwork resolves from a scratch catalog, so the Thumbnail rows time SMTC and the index rather than the network
+    std::filesystem::path catalogPath = std::filesystem::temp_directory_path() / L"amrp-benchmark-catalog.idx";
+    auto catalog = std::make_shared<CatalogIndex>();
+    catalog->Open(catalogPath.wstring());
+
+    PlayerInfo current = player->ForceUpdate(PlayerForceUpdateFlags::None, false);
+    catalog->Add(current.artist, current.albumTitle, { "https://example.invalid/artwork.jpg", "https://example.invalid/album" });
+    player->SetCatalogIndex(catalog);
+
+    constexpr size_t Iterations = 2000;
+    constexpr auto Timeline = PlayerForceUpdateFlags::Duration | PlayerForceUpdateFlags::Position;
+
+    MeasureNanoseconds("ForceUpdate(None)", Iterations, [&] { player->ForceUpdate(PlayerForceUpdateFlags::None, false); });
+    MeasureNanoseconds("Refresh<None>", Iterations, [&] { player->Refresh<PlayerForceUpdateFlags::None>(false); });
+
+    MeasureNanoseconds("ForceUpdate(Duration | Position)", Iterations, [&] { player->ForceUpdate(Timeline, false); });
+    MeasureNanoseconds("Refresh<Duration | Position>", Iterations, [&] { player->Refresh<Timeline>(false); });
+
+    // Position alone, the field a progress tick needs; it extrapolates from the same timeline sample
+    MeasureNanoseconds("ForceUpdate(Position)", Iterations, [&] { player->ForceUpdate(PlayerForceUpdateFlags::Position, false); });
+    MeasureNanoseconds("Refresh<Position>", Iterations, [&] { player->Refresh<PlayerForceUpdateFlags::Position>(false); });
+
+    MeasureNanoseconds("ForceUpdate(Thumbnail)", Iterations, [&] { player->ForceUpdate(PlayerForceUpdateFlags::Thumbnail, false); });
+    MeasureNanoseconds("Refresh<Thumbnail>", Iterations, [&] { player->Refresh<PlayerForceUpdateFlags::Thumbnail>(false); });
+
+    player.reset();
+    catalog->Close();
+
+    std::error_code ignored;
+    std::filesystem::remove(catalogPath, ignored);
+    std::filesystem::remove(catalogPath.wstring() + L".log", ignored);
+}
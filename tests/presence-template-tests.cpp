@@ -0,0 +1,134 @@
+#include "test-harness.h"
+
+#include "../discord-ipc/json-writer.h"
+#include "../memory/update-arena.h"
+#include "../presence/activity-payload.h"
+#include "../strings/string-utils.h"
+
+using PlaybackStatus = GlobalSystemMediaTransportControlsSessionPlaybackStatus;
+
+// The builder the templates replaced, with details/state/large_text hard-coded; kept as the baseline
+static void HardCodedActivityPayload(const PlayerInfo& info, std::pmr::string& out) {
+    auto nowSeconds = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    int64_t posSeconds = std::chrono::duration_cast<std::chrono::seconds>(info.position).count();
+    int64_t durSeconds = std::chrono::duration_cast<std::chrono::seconds>(info.duration).count();
+
+    std::pmr::memory_resource* resource = out.get_allocator().resource();
+    std::pmr::string title(resource), artist(resource), album(resource);
+    WideToUTF8(info.title, title);
+    WideToUTF8(info.artist, artist);
+    WideToUTF8(info.albumTitle, album);
+
+    JsonWriter<std::pmr::string> writer(out);
+    writer.BeginObject();
+
+    writer.Key("type");
+    writer.Int(2);
+
+    writer.Key("details");
+    writer.String(title);
+
+    writer.Key("state");
+    if (info.playbackStatus == PlaybackStatus::Paused) {
+        std::pmr::string state("Paused | ", resource);
+        state += artist;
+        writer.String(state);
+    }
+    else {
+        writer.String(artist);
+    }
+
+    writer.Key("assets");
+    writer.BeginObject();
+    if (!album.empty()) {
+        writer.Key("large_text");
+        writer.String(album);
+    }
+    writer.Key("large_image");
+    writer.String((info.thumbnailUrl.has_value() && !info.thumbnailUrl->empty())
+        ? std::string_view(*info.thumbnailUrl)
+        : std::string_view("apple_music_logo"));
+    writer.EndObject();
+
+    writer.Key("buttons");
+    writer.BeginArray();
+    writer.BeginObject();
+    writer.Key("label");
+    writer.String("Play on Music");
+    writer.Key("url");
+    writer.String(info.albumUrl.has_value() && !info.albumUrl->empty()
+        ? std::string_view(*info.albumUrl)
+        : std::string_view("https://music.apple.com/"));
+    writer.EndObject();
+    writer.EndArray();
+
+    if (info.playbackStatus == PlaybackStatus::Playing) {
+        int64_t startTime = (info.startTime.time_since_epoch().count() != 0)
+            ? std::chrono::duration_cast<std::chrono::seconds>(info.startTime.time_since_epoch()).count()
+            : nowSeconds - posSeconds;
+
+        writer.Key("timestamps");
+        writer.BeginObject();
+        writer.Key("start");
+        writer.Int(startTime);
+        writer.Key("end");
+        writer.Int(startTime + durSeconds);
+        writer.EndObject();
+    }
+
+    writer.EndObject();
+}
+
+static PlayerInfo TrackWithStatus(PlaybackStatus status) {
+    PlayerInfo info;
+    info.title = L"Windowlicker";
+    info.artist = L"Aphex Twin";
+    info.albumTitle = L"Windowlicker";
+    info.duration = std::chrono::seconds(367);
+    info.position = std::chrono::seconds(61);
+    info.startTime = std::chrono::system_clock::time_point(std::chrono::seconds(1700000000));
+    info.playbackStatus = status;
+    info.thumbnailUrl = "https://is1-ssl.mzstatic.com/image/thumb/Music/100x100bb.jpg";
+    info.albumUrl = "https://music.apple.com/us/album/windowlicker/1";
+    return info;
+}
+
+// The shipped defaults must reproduce the old payload byte for byte
+TEST(DefaultTemplatesMatchHardCodedPayload) {
+    PresenceTemplates templates = PresenceTemplates::Defaults();
+
+    for (auto status : { PlaybackStatus::Playing, PlaybackStatus::Paused, PlaybackStatus::Stopped }) {
+        PlayerInfo info = TrackWithStatus(status);
+
+        std::pmr::string rendered, hardCoded;
+        BuildActivityPayload(info, templates, rendered);
+        HardCodedActivityPayload(info, hardCoded);
+        CHECK(rendered == hardCoded);
+    }
+}
+
+// Per-update cost of the template renderer against the hard-coded builder, both into a reset arena as in
+// PublishAsync
+BENCHMARK(TemplateRenderVersusHardCodedPayload) {
+    constexpr size_t Iterations = 200000;
+
+    PresenceTemplates templates = PresenceTemplates::Defaults();
+    UpdateArena arena;
+
+    for (auto status : { PlaybackStatus::Playing, PlaybackStatus::Paused }) {
+        PlayerInfo info = TrackWithStatus(status);
+        std::printf(" %s\n", status == PlaybackStatus::Playing ? "playing" : "paused");
+
+        MeasureNanoseconds("hard-coded builder", Iterations, [&] {
+            arena.Reset();
+            std::pmr::string activity(arena.Resource());
+            HardCodedActivityPayload(info, activity);
+        });
+
+        MeasureNanoseconds("compiled templates", Iterations, [&] {
+            arena.Reset();
+            std::pmr::string activity(arena.Resource());
+            BuildActivityPayload(info, templates, activity);
+        });
+    }
+}
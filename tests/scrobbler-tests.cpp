@@ -0,0 +1,384 @@
+// Winsock 2 has to come before anything that pulls in windows.h
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#include "test-harness.h"
+
+#include "../scrobbler/scrobbler.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Loopback HTTP server standing in for the scrobbling endpoint. Each POST is answered with the next scripted
+// status (200 once the script runs out), and its arrival time and play count are recorded.
+class StandInEndpoint {
+public:
+    struct Request {
+        std::chrono::steady_clock::time_point receivedAt;
+        size_t plays = 0;
+        int status = 0;
+    };
+
+    explicit StandInEndpoint(std::deque<int> statuses = {}) : m_statuses(std::move(statuses)) {
+        WSADATA wsa;
+        WSAStartup(MAKEWORD(2, 2), &wsa);
+
+        m_listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0; // Any free port
+        bind(m_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        listen(m_listener, SOMAXCONN);
+
+        int length = sizeof(address);
+        getsockname(m_listener, reinterpret_cast<sockaddr*>(&address), &length);
+        m_port = ntohs(address.sin_port);
+
+        m_thread = std::thread([this] { Serve(); });
+    }
+
+    ~StandInEndpoint() {
+        closesocket(m_listener); // Fails the pending accept, which ends Serve
+        m_thread.join();
+        WSACleanup();
+    }
+
+    StandInEndpoint(const StandInEndpoint&) = delete;
+    StandInEndpoint& operator=(const StandInEndpoint&) = delete;
+
+    std::wstring Url() const {
+        return L"http://127.0.0.1:" + std::to_wstring(m_port) + L"/scrobbles";
+    }
+
+    // Waits until count requests have been answered or timeout passes, then returns all of them
+    std::vector<Request> WaitForRequests(size_t count, std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait_for(lock, timeout, [&] { return m_requests.size() >= count; });
+        return m_requests;
+    }
+
+private:
+    SOCKET m_listener = INVALID_SOCKET;
+    uint16_t m_port = 0;
+    std::thread m_thread;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<int> m_statuses;
+    std::vector<Request> m_requests;
+
+    void Serve() {
+        while (true) {
+            SOCKET client = accept(m_listener, nullptr, nullptr);
+            if (client == INVALID_SOCKET) return;
+
+            Answer(client);
+            closesocket(client);
+        }
+    }
+
+    void Answer(SOCKET client) {
+        std::string request;
+        std::string headers;
+        size_t bodyStart = std::string::npos;
+        size_t contentLength = 0;
+
+        char buffer[4096];
+        while (bodyStart == std::string::npos || request.size() < bodyStart + contentLength) {
+            int received = recv(client, buffer, sizeof(buffer), 0);
+            if (received <= 0) return;
+            request.append(buffer, static_cast<size_t>(received));
+
+            if (bodyStart != std::string::npos) continue;
+
+            size_t headerEnd = request.find("\r\n\r\n");
+            if (headerEnd == std::string::npos) continue;
+            bodyStart = headerEnd + 4;
+
+            headers = request.substr(0, headerEnd);
+            std::transform(headers.begin(), headers.end(), headers.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+            size_t length = headers.find("\r\ncontent-length:");
+            if (length != std::string::npos) {
+                contentLength = std::stoul(headers.substr(length + 17));
+            }
+            if (headers.find("\r\nexpect: 100-continue") != std::string::npos) {
+                static const char Continue[] = "HTTP/1.1 100 Continue\r\n\r\n";
+                send(client, Continue, static_cast<int>(sizeof(Continue) - 1), 0);
+            }
+        }
+
+        auto body = nlohmann::json::parse(request.substr(bodyStart, contentLength), nullptr, false);
+
+        Request answered;
+        answered.receivedAt = std::chrono::steady_clock::now();
+        answered.plays = (body.is_object() && body.contains("scrobbles")) ? body["scrobbles"].size() : 0;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            answered.status = m_statuses.empty() ? 200 : m_statuses.front();
+            if (!m_statuses.empty()) m_statuses.pop_front();
+            m_requests.push_back(answered);
+        }
+        m_cv.notify_all();
+
+        std::string response = "HTTP/1.1 " + std::to_string(answered.status) + " Scripted\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        send(client, response.data(), static_cast<int>(response.size()), 0);
+        shutdown(client, SD_SEND);
+    }
+};
+
+// A journal of its own per test; the journal and its side files are removed before and after
+class ScratchJournal {
+public:
+    explicit ScratchJournal(const wchar_t* name)
+        : m_path((std::filesystem::temp_directory_path() / (std::wstring(L"amrp-scrobbles-") + name + L"-" + std::to_wstring(GetCurrentProcessId()) + L".jsonl")).wstring()) {
+        Remove();
+    }
+
+    ~ScratchJournal() {
+        Remove();
+    }
+
+    const std::wstring& Path() const { return m_path; }
+    std::wstring ParkedPath() const { return m_path + L".parked"; }
+
+    static size_t Lines(const std::wstring& path) {
+        std::ifstream in(std::filesystem::path(path), std::ios::binary);
+        size_t lines = 0;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty()) ++lines;
+        }
+        return lines;
+    }
+
+private:
+    std::wstring m_path;
+
+    void Remove() {
+        std::error_code ignored;
+        for (const wchar_t* suffix : { L"", L".parked", L".tmp" }) {
+            std::filesystem::remove(m_path + suffix, ignored);
+        }
+    }
+};
+
+static ScrobblerConfig ConfigFor(const StandInEndpoint& endpoint, size_t batchSize, std::chrono::milliseconds maxDelay) {
+    ScrobblerConfig config;
+    config.endpoint = endpoint.Url();
+    config.batchSize = batchSize;
+    config.maxDelay = maxDelay;
+    config.minBackoff = std::chrono::milliseconds(100);
+    config.maxBackoff = std::chrono::milliseconds(400);
+    return config;
+}
+
+static PlayRecord Play(int n) {
+    PlayRecord play;
+    play.title = L"Track " + std::to_wstring(n);
+    play.artist = L"Khruangbin";
+    play.albumTitle = L"Mordechai";
+    play.startedAt = std::chrono::system_clock::now();
+    play.duration = std::chrono::seconds(200);
+    play.played = std::chrono::seconds(150);
+    return play;
+}
+
+// Stats are updated after the response is handled, a moment after the endpoint has answered
+template <typename Predicate>
+static ScrobblerStats WaitForStats(Scrobbler& scrobbler, Predicate done) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    ScrobblerStats stats = scrobbler.Stats();
+    while (!done(stats) && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        stats = scrobbler.Stats();
+    }
+    return stats;
+}
+
+static long long Milliseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+}
+
+TEST(ScrobblerSendsOneRequestPerFullBatch) {
+    ScratchJournal journal(L"batches");
+    StandInEndpoint endpoint;
+
+    Scrobbler scrobbler(ConfigFor(endpoint, 5, std::chrono::seconds(30)), journal.Path());
+    scrobbler.Start();
+
+    for (int i = 0; i < 10; ++i) {
+        scrobbler.Submit(Play(i));
+    }
+
+    auto requests = endpoint.WaitForRequests(2, std::chrono::seconds(10));
+    auto stats = WaitForStats(scrobbler, [](const ScrobblerStats& stats) { return stats.playsSubmitted == 10; });
+
+    CHECK(requests.size() == 2);
+    CHECK(requests.size() == 2 && requests[0].plays == 5 && requests[1].plays == 5);
+    CHECK(stats.requests == 2);
+    CHECK(stats.playsSubmitted == 10);
+
+    // Full batches go out as soon as they fill rather than waiting out maxDelay
+    CHECK(stats.maxFlushLatency < std::chrono::seconds(5));
+
+    std::printf("  %.2f requests/play, max flush latency %lld ms\n",
+        static_cast<double>(stats.requests) / static_cast<double>((std::max)(stats.playsSubmitted, uint64_t(1))),
+        static_cast<long long>(stats.maxFlushLatency.count()));
+
+    scrobbler.Stop();
+    CHECK(ScratchJournal::Lines(journal.Path()) == 0);
+}
+
+TEST(ScrobblerFlushesPartialBatchAfterMaxDelay) {
+    ScratchJournal journal(L"partial");
+    StandInEndpoint endpoint;
+
+    constexpr auto MaxDelay = std::chrono::milliseconds(300);
+    Scrobbler scrobbler(ConfigFor(endpoint, 50, MaxDelay), journal.Path());
+    scrobbler.Start();
+
+    auto submittedAt = std::chrono::steady_clock::now();
+    for (int i = 0; i < 3; ++i) {
+        scrobbler.Submit(Play(i));
+    }
+
+    auto requests = endpoint.WaitForRequests(1, std::chrono::seconds(10));
+    auto stats = WaitForStats(scrobbler, [](const ScrobblerStats& stats) { return stats.playsSubmitted == 3; });
+
+    CHECK(requests.size() == 1);
+    if (requests.size() != 1) return;
+
+    auto latency = requests[0].receivedAt - submittedAt;
+    CHECK(requests[0].plays == 3);
+    CHECK(latency >= MaxDelay);
+    CHECK(latency < std::chrono::seconds(5));
+    CHECK(stats.lastFlushLatency >= MaxDelay);
+
+    std::printf("  %zu plays in 1 request, flush latency %lld ms (maxDelay %lld ms)\n",
+        requests[0].plays, Milliseconds(latency), static_cast<long long>(MaxDelay.count()));
+
+    scrobbler.Stop();
+}
+
+TEST(ScrobblerBacksOffOnServerErrors) {
+    ScratchJournal journal(L"backoff");
+    StandInEndpoint endpoint({ 503, 500 });
+
+    auto config = ConfigFor(endpoint, 2, std::chrono::seconds(30));
+    Scrobbler scrobbler(config, journal.Path());
+    scrobbler.Start();
+
+    scrobbler.Submit(Play(1));
+    scrobbler.Submit(Play(2));
+
+    auto requests = endpoint.WaitForRequests(3, std::chrono::seconds(10));
+    auto stats = WaitForStats(scrobbler, [](const ScrobblerStats& stats) { return stats.playsSubmitted == 2; });
+
+    CHECK(requests.size() == 3);
+    if (requests.size() != 3) return;
+
+    CHECK(requests[0].status == 503 && requests[1].status == 500 && requests[2].status == 200);
+    CHECK(requests[0].plays == 2 && requests[1].plays == 2 && requests[2].plays == 2);
+
+    // The wait doubles per consecutive failure
+    auto firstRetry = requests[1].receivedAt - requests[0].receivedAt;
+    auto secondRetry = requests[2].receivedAt - requests[1].receivedAt;
+    CHECK(firstRetry >= config.minBackoff);
+    CHECK(secondRetry >= 2 * config.minBackoff);
+
+    CHECK(stats.requests == 3);
+    CHECK(stats.playsSubmitted == 2);
+
+    std::printf("  retries after %lld ms and %lld ms, %.2f requests/play\n", Milliseconds(firstRetry), Milliseconds(secondRetry),
+        static_cast<double>(stats.requests) / static_cast<double>((std::max)(stats.playsSubmitted, uint64_t(1))));
+
+    scrobbler.Stop();
+    CHECK(ScratchJournal::Lines(journal.Path()) == 0);
+}
+
+// Refused credentials are not retried; the batch is parked and goes out again on the next start
+TEST(ScrobblerParksBatchesRefusedForCredentials) {
+    ScratchJournal journal(L"parked");
+
+    {
+        StandInEndpoint endpoint({ 401 });
+        Scrobbler scrobbler(ConfigFor(endpoint, 2, std::chrono::seconds(30)), journal.Path());
+        scrobbler.Start();
+
+        scrobbler.Submit(Play(1));
+        scrobbler.Submit(Play(2));
+
+        auto stats = WaitForStats(scrobbler, [](const ScrobblerStats& stats) { return stats.playsParked == 2; });
+        CHECK(stats.playsParked == 2);
+
+        // Several backoff periods pass without another attempt
+        std::this_thread::sleep_for(std::chrono::milliseconds(600));
+        CHECK(endpoint.WaitForRequests(1, std::chrono::seconds(0)).size() == 1);
+
+        scrobbler.Stop();
+        CHECK(ScratchJournal::Lines(journal.Path()) == 0);
+        CHECK(ScratchJournal::Lines(journal.ParkedPath()) == 2);
+    }
+
+    StandInEndpoint endpoint;
+    Scrobbler scrobbler(ConfigFor(endpoint, 50, std::chrono::seconds(30)), journal.Path());
+    scrobbler.Start();
+
+    // Requeued plays are due immediately, without waiting for a full batch
+    auto requests = endpoint.WaitForRequests(1, std::chrono::seconds(10));
+    auto stats = WaitForStats(scrobbler, [](const ScrobblerStats& stats) { return stats.playsSubmitted == 2; });
+    CHECK(requests.size() == 1 && requests[0].plays == 2);
+    CHECK(stats.playsSubmitted == 2);
+
+    scrobbler.Stop();
+    CHECK(!std::filesystem::exists(journal.ParkedPath()));
+    CHECK(ScratchJournal::Lines(journal.Path()) == 0);
+}
+
+// Plays still queued when the scrobbler stops are journaled and sent by the next run
+TEST(ScrobblerKeepsQueuedPlaysAcrossRestarts) {
+    ScratchJournal journal(L"restart");
+
+    {
+        // Offline: the only attempt fails and the retry is far off
+        StandInEndpoint endpoint({ 503 });
+        auto config = ConfigFor(endpoint, 3, std::chrono::seconds(30));
+        config.minBackoff = std::chrono::minutes(5);
+
+        Scrobbler scrobbler(config, journal.Path());
+        scrobbler.Start();
+        for (int i = 0; i < 3; ++i) {
+            scrobbler.Submit(Play(i));
+        }
+
+        CHECK(endpoint.WaitForRequests(1, std::chrono::seconds(10)).size() == 1);
+        WaitForStats(scrobbler, [](const ScrobblerStats& stats) { return stats.requests == 1; });
+        scrobbler.Stop();
+        CHECK(ScratchJournal::Lines(journal.Path()) == 3);
+    }
+
+    StandInEndpoint endpoint;
+    Scrobbler scrobbler(ConfigFor(endpoint, 50, std::chrono::seconds(30)), journal.Path());
+    scrobbler.Start();
+
+    auto requests = endpoint.WaitForRequests(1, std::chrono::seconds(10));
+    CHECK(requests.size() == 1 && requests[0].plays == 3);
+
+    WaitForStats(scrobbler, [](const ScrobblerStats& stats) { return stats.playsSubmitted == 3; });
+    scrobbler.Stop();
+    CHECK(ScratchJournal::Lines(journal.Path()) == 0);
+}
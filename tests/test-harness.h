@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// Minimal self-registering test runner. TEST bodies run on every invocation; BENCHMARK bodies only
+// with --benchmark, since their timings are meant to be read rather than asserted.
+struct TestCase {
+    const char* name;
+    void (*run)();
+    bool benchmark;
+};
+
+std::vector<TestCase>& TestRegistry();
+
+// Records a failed CHECK; the runner exits non-zero if any were recorded
+void ReportFailure(const char* file, int line, const char* expression);
+
+struct TestRegistrar {
+    TestRegistrar(const char* name, void (*run)(), bool benchmark) {
+        TestRegistry().push_back({ name, run, benchmark });
+    }
+};
+
+#define TEST(name) \
+    static void name(); \
+    static TestRegistrar name##Registrar(#name, &name, false); \
+    static void name()
+
+#define BENCHMARK(name) \
+    static void name(); \
+    static TestRegistrar name##Registrar(#name, &name, true); \
+    static void name()
+
+#define CHECK(expression) \
+    do { if (!(expression)) ReportFailure(__FILE__, __LINE__, #expression); } while (0)
+
+// Times iterations calls of body and prints the per-call average under label
+template <typename Body>
+double MeasureNanoseconds(const char* label, size_t iterations, Body&& body) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        body();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+    double perCall = static_cast<double>(elapsed.count()) / static_cast<double>(iterations);
+    std::printf("  %-40s %10.1f ns/call\n", label, perCall);
+    return perCall;
+}
@@ -0,0 +1,45 @@
+#include "test-harness.h"
+
+#include <winrt/Windows.Foundation.h>
+
+#include <cstring>
+
+static int failures = 0;
+
+std::vector<TestCase>& TestRegistry() {
+    static std::vector<TestCase> registry;
+    return registry;
+}
+
+void ReportFailure(const char* file, int line, const char* expression) {
+    std::printf("  FAILED %s(%d): %s\n", file, line, expression);
+    ++failures;
+}
+
+// Usage: apple-music-rich-presence-tests [--benchmark] [name]
+int main(int argc, char** argv) {
+    winrt::init_apartment();
+
+    bool benchmarks = false;
+    const char* only = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--benchmark") == 0) benchmarks = true;
+        else only = argv[i];
+    }
+
+    int ran = 0;
+    for (const auto& test : TestRegistry()) {
+        if (test.benchmark != benchmarks) continue;
+        if (only && std::strcmp(only, test.name) != 0) continue;
+
+        std::printf("%s\n", test.name);
+        int before = failures;
+        test.run();
+        std::printf("  %s\n", failures == before ? "ok" : "FAILED");
+        ++ran;
+    }
+
+    std::printf("%d run, %d failed checks\n", ran, failures);
+    winrt::uninit_apartment();
+    return failures == 0 ? 0 : 1;
+}